@@ -0,0 +1,280 @@
+/*================================================================================
+ * The MIT License
+ *
+ * Copyright (c) 2018 Ryooooooga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+================================================================================*/
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include <boost/format.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+namespace meteor::benchmark
+{
+	// Command line shared by the benchmarks: [--warmup N] [--repetitions N] [--filter NAME] [--json FILE].
+	struct Options
+	{
+		std::size_t warmup = 1;
+		std::size_t repetitions = 20;
+		std::string filter;
+		std::string jsonPath;
+
+		[[nodiscard]]
+		bool selected(std::string_view name) const noexcept
+		{
+			return filter.empty() || name.find(filter) != std::string_view::npos;
+		}
+	};
+
+	// Parses the shared options; `extra' is called with the index of any other argument and returns the next index.
+	template <typename Extra>
+	[[nodiscard]]
+	Options parseOptions(int argc, char* argv[], Extra extra)
+	{
+		Options options;
+
+		for (int i = 1; i < argc; i++)
+		{
+			const std::string_view arg = argv[i];
+
+			if (arg == u8"--warmup" && i + 1 < argc)
+			{
+				options.warmup = std::stoul(argv[++i]);
+			}
+			else if (arg == u8"--repetitions" && i + 1 < argc)
+			{
+				options.repetitions = std::max(std::stoul(argv[++i]), 1ul);
+			}
+			else if (arg == u8"--filter" && i + 1 < argc)
+			{
+				options.filter = argv[++i];
+			}
+			else if (arg == u8"--json" && i + 1 < argc)
+			{
+				options.jsonPath = argv[++i];
+			}
+			else
+			{
+				i = extra(i);
+			}
+		}
+
+		return options;
+	}
+
+	[[nodiscard]]
+	inline Options parseOptions(int argc, char* argv[])
+	{
+		return parseOptions(argc, argv, [&](int i) -> int
+		{
+			throw std::runtime_error { (boost::format(u8"unknown option `%1%'.") % argv[i]).str() };
+		});
+	}
+
+	// Timings of the repetitions of one benchmark; `work' counts the units processed by one repetition.
+	struct Result
+	{
+		std::string name;
+		std::string unit;
+		std::uint64_t work;
+		std::vector<double> seconds;
+
+		[[nodiscard]]
+		double median() const
+		{
+			auto sorted = seconds;
+
+			std::sort(std::begin(sorted), std::end(sorted));
+
+			const auto n = sorted.size();
+
+			return n == 0 ? 0.0 : n % 2 == 1 ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2;
+		}
+
+		// Units per second at the median time.
+		[[nodiscard]]
+		double throughput() const
+		{
+			return work / std::max(median(), 1e-12);
+		}
+
+		// Nanoseconds per unit at the median time.
+		[[nodiscard]]
+		double nanosecondsPerUnit() const
+		{
+			return median() * 1e9 / std::max(work, std::uint64_t {1});
+		}
+	};
+
+	// Runs `prepare' then times `run' on its result, discarding the warm-up repetitions.
+	// `run' returns the number of units it processed.
+	template <typename Prepare, typename Run>
+	[[nodiscard]]
+	Result measure(const Options& options, std::string name, std::string unit, Prepare prepare, Run run)
+	{
+		auto result = Result { std::move(name), std::move(unit), 0, {} };
+
+		for (std::size_t i = 0; i < options.warmup + options.repetitions; i++)
+		{
+			auto state = prepare();
+
+			const auto start = std::chrono::steady_clock::now();
+			const auto work = run(state);
+			const auto elapsed = std::chrono::duration<double> { std::chrono::steady_clock::now() - start }.count();
+
+			if (i >= options.warmup)
+			{
+				result.work = work;
+				result.seconds.emplace_back(elapsed);
+			}
+		}
+
+		return result;
+	}
+
+	// Discards the output while still paying for the stream calls.
+	class NullBuffer
+		: public std::streambuf
+	{
+	protected:
+		int_type overflow(int_type c) override
+		{
+			return c;
+		}
+	};
+
+	// Peak resident set size of the process in KiB.
+	[[nodiscard]]
+	inline long peakResidentSetSize() noexcept
+	{
+		rusage usage {};
+
+		getrusage(RUSAGE_SELF, &usage);
+
+		return usage.ru_maxrss;
+	}
+
+	inline void printHeader(std::ostream& stream)
+	{
+		stream << boost::format(u8"%1$-24s %2$12s %3$-6s %4$12s %5$14s %6$10s") % u8"benchmark" % u8"work" % u8"unit" % u8"median ms" % u8"units/s" % u8"ns/unit" << std::endl;
+	}
+
+	inline void print(std::ostream& stream, const Result& result)
+	{
+		stream
+			<< boost::format(u8"%1$-24s %2$12d %3$-6s %4$12.3f %5$14.0f %6$10.2f")
+				% result.name
+				% result.work
+				% result.unit
+				% (result.median() * 1e3)
+				% result.throughput()
+				% result.nanosecondsPerUnit()
+			<< std::endl;
+	}
+
+	// Results of one benchmark executable, as stored by --json and read by meteor_bench_compare.
+	struct ResultSet
+	{
+		std::string suite;
+		std::vector<Result> results;
+	};
+
+	// {"suite":"...","results":[{"name":"...","unit":"...","work":N,"seconds":[...]}, ...]}
+	inline void write(std::ostream& stream, const ResultSet& set)
+	{
+		// Names are chosen by the benchmarks and never need escaping.
+		stream << boost::format(u8"{\"suite\":\"%1%\",\"results\":[") % set.suite;
+
+		for (std::size_t i = 0; i < set.results.size(); i++)
+		{
+			const auto& result = set.results[i];
+
+			stream
+				<< (i > 0 ? u8"," : u8"") << std::endl
+				<< boost::format(u8"{\"name\":\"%1%\",\"unit\":\"%2%\",\"work\":%3%,\"seconds\":[") % result.name % result.unit % result.work;
+
+			for (std::size_t j = 0; j < result.seconds.size(); j++)
+			{
+				stream << (j > 0 ? u8"," : u8"") << boost::format(u8"%1$.9g") % result.seconds[j];
+			}
+
+			stream << u8"]}";
+		}
+
+		stream << std::endl << u8"]}" << std::endl;
+	}
+
+	[[nodiscard]]
+	inline ResultSet read(std::istream& stream)
+	{
+		boost::property_tree::ptree tree;
+
+		boost::property_tree::read_json(stream, tree);
+
+		ResultSet set { tree.get<std::string>(u8"suite"), {} };
+
+		for (const auto& [key, child] : tree.get_child(u8"results"))
+		{
+			auto result = Result { child.get<std::string>(u8"name"), child.get<std::string>(u8"unit"), child.get<std::uint64_t>(u8"work"), {} };
+
+			for (const auto& [index, seconds] : child.get_child(u8"seconds"))
+			{
+				result.seconds.emplace_back(seconds.get_value<double>());
+			}
+
+			set.results.emplace_back(std::move(result));
+		}
+
+		return set;
+	}
+
+	// Writes the results to --json FILE, if given.
+	inline void save(const Options& options, const ResultSet& set)
+	{
+		if (options.jsonPath.empty())
+		{
+			return;
+		}
+
+		std::ofstream stream { options.jsonPath };
+
+		if (!stream)
+		{
+			throw std::runtime_error { (boost::format(u8"cannot open `%1%'.") % options.jsonPath).str() };
+		}
+
+		write(stream, set);
+	}
+}
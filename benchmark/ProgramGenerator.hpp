@@ -0,0 +1,223 @@
+/*================================================================================
+ * The MIT License
+ *
+ * Copyright (c) 2018 Ryooooooga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+================================================================================*/
+
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <string>
+
+namespace meteor::benchmark
+{
+	// Generates valid programs in the C subset the compiler accepts: `functions' functions of
+	// `statements' top-level statements each, with expressions up to `depth' operators deep and if/while
+	// blocks of one to three statements nested up to `nesting' levels. Every function may call the ones defined before it; main calls the last one.
+	// The programs are meant to be compiled, not run: loops need not terminate.
+	class ProgramGenerator
+	{
+	public:
+		struct Parameters
+		{
+			std::size_t functions = 40; // About 1000 words each; the image must stay under 64K words.
+			std::size_t statements = 8;
+			std::size_t depth = 2;
+			std::size_t nesting = 2;
+		};
+
+		explicit ProgramGenerator(const Parameters& parameters, std::uint64_t seed = 1)
+			: m_parameters(parameters)
+			, m_random(seed)
+			, m_source()
+			, m_function(0)
+		{
+		}
+
+		// Uncopyable, movable.
+		ProgramGenerator(const ProgramGenerator&) =delete;
+		ProgramGenerator(ProgramGenerator&&) =default;
+
+		ProgramGenerator& operator=(const ProgramGenerator&) =delete;
+		ProgramGenerator& operator=(ProgramGenerator&&) =default;
+
+		~ProgramGenerator() =default;
+
+		[[nodiscard]]
+		std::string generate()
+		{
+			m_source.clear();
+
+			for (m_function = 0; m_function < m_parameters.functions; m_function++)
+			{
+				m_source += u8"int f" + std::to_string(m_function) + u8"(int a, int b) {\n";
+				m_source += u8"\tint x;\n\tint y;\n\tint *p;\n\n\tx = a;\n\ty = b;\n\tp = &x;\n";
+
+				generateBlock(1, m_parameters.nesting, m_parameters.statements);
+
+				m_source += u8"\treturn ";
+				generateExpression(m_parameters.depth);
+				m_source += u8";\n}\n\n";
+			}
+
+			m_source += u8"int main(void) {\n\treturn ";
+
+			if (m_parameters.functions > 0)
+			{
+				m_source += u8"f" + std::to_string(m_parameters.functions - 1) + u8"(1, 2)";
+			}
+			else
+			{
+				m_source += u8"0";
+			}
+
+			m_source += u8";\n}\n";
+
+			return std::move(m_source);
+		}
+
+	private:
+		void indent(std::size_t level)
+		{
+			m_source.append(level, '\t');
+		}
+
+		void generateBlock(std::size_t level, std::size_t nesting, std::size_t statements)
+		{
+			for (std::size_t i = 0; i < statements; i++)
+			{
+				generateStatement(level, nesting);
+			}
+		}
+
+		void generateStatement(std::size_t level, std::size_t nesting)
+		{
+			indent(level);
+
+			switch (nesting > 0 ? pick(6) : 3 + pick(3))
+			{
+				case 0:
+				case 1:
+					m_source += u8"if (";
+					generateExpression(m_parameters.depth);
+					m_source += u8") {\n";
+					generateBlock(level + 1, nesting - 1, 1 + pick(3));
+					indent(level);
+
+					if (pick(2) == 0)
+					{
+						m_source += u8"}\n";
+					}
+					else
+					{
+						m_source += u8"} else {\n";
+						generateBlock(level + 1, nesting - 1, 1 + pick(3));
+						indent(level);
+						m_source += u8"}\n";
+					}
+					break;
+
+				case 2:
+					m_source += u8"while (y) {\n";
+					generateBlock(level + 1, nesting - 1, 1 + pick(3));
+					indent(level + 1);
+					m_source += u8"y = y - 1;\n";
+					indent(level);
+					m_source += u8"}\n";
+					break;
+
+				case 3:
+					m_source += u8"*p = ";
+					generateExpression(m_parameters.depth);
+					m_source += u8";\n";
+					break;
+
+				default:
+					m_source += pick(2) == 0 ? u8"x = " : u8"y = ";
+					generateExpression(m_parameters.depth);
+					m_source += u8";\n";
+					break;
+			}
+		}
+
+		void generateExpression(std::size_t depth)
+		{
+			if (depth == 0)
+			{
+				switch (pick(4))
+				{
+					case 0:  m_source += u8"a"; break;
+					case 1:  m_source += u8"b"; break;
+					case 2:  m_source += u8"*p"; break;
+					default: m_source += std::to_string(pick(1000)); break;
+				}
+
+				return;
+			}
+
+			switch (pick(m_function > 0 ? 5 : 4))
+			{
+				case 0:
+					m_source += u8"-(";
+					generateExpression(depth - 1);
+					m_source += u8")";
+					break;
+
+				case 1:
+					m_source += u8"(";
+					generateExpression(depth - 1);
+					m_source += u8" - ";
+					generateExpression(depth - 1);
+					m_source += u8")";
+					break;
+
+				case 4:
+					m_source += u8"f" + std::to_string(pick(m_function)) + u8"(";
+					generateExpression(depth - 1);
+					m_source += u8", ";
+					generateExpression(depth - 1);
+					m_source += u8")";
+					break;
+
+				default:
+					m_source += u8"(";
+					generateExpression(depth - 1);
+					m_source += u8" + ";
+					generateExpression(depth - 1);
+					m_source += u8")";
+					break;
+			}
+		}
+
+		// Uniform in [0, n).
+		[[nodiscard]]
+		std::size_t pick(std::size_t n)
+		{
+			return std::uniform_int_distribution<std::size_t> { 0, n - 1 }(m_random);
+		}
+
+		Parameters m_parameters;
+		std::mt19937_64 m_random;
+		std::string m_source;
+		std::size_t m_function;
+	};
+}
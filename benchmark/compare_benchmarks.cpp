@@ -0,0 +1,370 @@
+/*================================================================================
+ * The MIT License
+ *
+ * Copyright (c) 2018 Ryooooooga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+================================================================================*/
+
+// meteor_bench_compare BASELINE CANDIDATE [--threshold PERCENT] [--confidence LEVEL] [--resamples N] [--seed N] [--allow-missing]
+// Compares two --json result files benchmark by benchmark and exits with 1 on a significant regression,
+// or when a baseline benchmark is missing from the candidate or has no samples (unless --allow-missing).
+// A change is significant when the Mann-Whitney test rejects equal timings and the whole bootstrap
+// interval of the change lies beyond the threshold.
+// Results without timings are exact counts, compared as such.
+
+#include "Benchmark.hpp"
+
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+
+namespace
+{
+	struct Options
+	{
+		std::string baselinePath;
+		std::string candidatePath;
+		double threshold = 0.05;
+		double confidence = 0.95;
+		std::size_t resamples = 10000;
+		std::uint64_t seed = 1;
+		bool allowMissing = false;
+	};
+
+	[[nodiscard]]
+	Options parseOptions(int argc, char* argv[])
+	{
+		Options options;
+
+		for (int i = 1; i < argc; i++)
+		{
+			const std::string_view arg = argv[i];
+
+			if (arg == u8"--threshold" && i + 1 < argc)
+			{
+				options.threshold = std::stod(argv[++i]) / 100.0;
+			}
+			else if (arg == u8"--confidence" && i + 1 < argc)
+			{
+				options.confidence = std::stod(argv[++i]);
+			}
+			else if (arg == u8"--resamples" && i + 1 < argc)
+			{
+				options.resamples = std::max(std::stoul(argv[++i]), 1ul);
+			}
+			else if (arg == u8"--seed" && i + 1 < argc)
+			{
+				options.seed = std::stoull(argv[++i]);
+			}
+			else if (arg == u8"--allow-missing")
+			{
+				options.allowMissing = true;
+			}
+			else if (!arg.empty() && arg[0] != u8'-' && options.baselinePath.empty())
+			{
+				options.baselinePath = arg;
+			}
+			else if (!arg.empty() && arg[0] != u8'-' && options.candidatePath.empty())
+			{
+				options.candidatePath = arg;
+			}
+			else
+			{
+				throw std::runtime_error { (boost::format(u8"unknown option `%1%'.") % arg).str() };
+			}
+		}
+
+		if (options.candidatePath.empty())
+		{
+			throw std::runtime_error { u8"usage: meteor_bench_compare BASELINE CANDIDATE [--threshold PERCENT] [--confidence LEVEL] [--resamples N] [--seed N] [--allow-missing]" };
+		}
+
+		return options;
+	}
+
+	[[nodiscard]]
+	meteor::benchmark::ResultSet load(const std::string& path)
+	{
+		std::ifstream stream { path };
+
+		if (!stream)
+		{
+			throw std::runtime_error { (boost::format(u8"cannot open `%1%'.") % path).str() };
+		}
+
+		return meteor::benchmark::read(stream);
+	}
+
+	// Seconds per unit of work, so that runs with different amounts of work stay comparable.
+	[[nodiscard]]
+	std::vector<double> normalize(const meteor::benchmark::Result& result)
+	{
+		auto samples = result.seconds;
+
+		for (auto& s : samples)
+		{
+			s /= std::max(result.work, std::uint64_t {1});
+		}
+
+		return samples;
+	}
+
+	[[nodiscard]]
+	double median(std::vector<double> samples)
+	{
+		return meteor::benchmark::Result { {}, {}, 1, std::move(samples) }.median();
+	}
+
+	// Two-sided p-value of the Mann-Whitney U test, by the normal approximation with tie correction.
+	[[nodiscard]]
+	double mannWhitney(const std::vector<double>& a, const std::vector<double>& b)
+	{
+		std::vector<std::pair<double, bool>> pooled;
+
+		for (const auto x : a)
+		{
+			pooled.emplace_back(x, true);
+		}
+
+		for (const auto x : b)
+		{
+			pooled.emplace_back(x, false);
+		}
+
+		std::sort(std::begin(pooled), std::end(pooled));
+
+		const auto n1 = static_cast<double>(a.size());
+		const auto n2 = static_cast<double>(b.size());
+		const auto n = n1 + n2;
+
+		double rankSum = 0.0;
+		double ties = 0.0;
+
+		for (std::size_t i = 0; i < pooled.size();)
+		{
+			auto j = i;
+
+			while (j < pooled.size() && pooled[j].first == pooled[i].first)
+			{
+				j++;
+			}
+
+			// Tied values share the mean of their ranks.
+			const auto rank = (i + j + 1) / 2.0;
+			const auto t = static_cast<double>(j - i);
+
+			for (auto k = i; k < j; k++)
+			{
+				if (pooled[k].second)
+				{
+					rankSum += rank;
+				}
+			}
+
+			ties += t * t * t - t;
+			i = j;
+		}
+
+		const auto u = rankSum - n1 * (n1 + 1) / 2;
+		const auto mean = n1 * n2 / 2;
+		const auto variance = n1 * n2 / 12 * ((n + 1) - ties / (n * (n - 1)));
+
+		if (variance <= 0.0)
+		{
+			return 1.0;
+		}
+
+		const auto z = std::max(std::abs(u - mean) - 0.5, 0.0) / std::sqrt(variance);
+
+		return std::erfc(z / std::sqrt(2.0));
+	}
+
+	// Percentile bootstrap interval of the relative change of the median.
+	[[nodiscard]]
+	std::pair<double, double> bootstrap(const std::vector<double>& a, const std::vector<double>& b, const Options& options)
+	{
+		std::mt19937_64 random { options.seed };
+		std::vector<double> deltas;
+		std::vector<double> x(a.size());
+		std::vector<double> y(b.size());
+
+		const auto resample = [&](const std::vector<double>& from, std::vector<double>& to)
+		{
+			std::uniform_int_distribution<std::size_t> index { 0, from.size() - 1 };
+
+			for (auto& v : to)
+			{
+				v = from[index(random)];
+			}
+
+			return median(to);
+		};
+
+		deltas.reserve(options.resamples);
+
+		for (std::size_t i = 0; i < options.resamples; i++)
+		{
+			const auto before = resample(a, x);
+			const auto after = resample(b, y);
+
+			deltas.emplace_back(after / std::max(before, 1e-300) - 1.0);
+		}
+
+		std::sort(std::begin(deltas), std::end(deltas));
+
+		const auto tail = (1.0 - options.confidence) / 2;
+		const auto at = [&](double q)
+		{
+			return deltas[std::min(static_cast<std::size_t>(q * deltas.size()), deltas.size() - 1)];
+		};
+
+		return { at(tail), at(1.0 - tail) };
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	try
+	{
+		const auto options = parseOptions(argc, argv);
+		const auto baseline = load(options.baselinePath);
+		const auto candidate = load(options.candidatePath);
+
+		if (baseline.suite != candidate.suite)
+		{
+			std::cout << boost::format(u8"note: comparing suite `%1%' with `%2%'.") % baseline.suite % candidate.suite << std::endl;
+		}
+
+		std::map<std::string, const meteor::benchmark::Result*> before;
+
+		for (const auto& result : baseline.results)
+		{
+			before.emplace(result.name, &result);
+		}
+
+		std::cout
+			<< boost::format(u8"%1$-32s %2$12s %3$12s %4$9s %5$21s %6$8s  %7%")
+				% u8"benchmark" % u8"base ns/unit" % u8"new ns/unit" % u8"delta" % (boost::format(u8"%1$.0f%% interval") % (options.confidence * 100)) % u8"p" % u8"verdict"
+			<< std::endl;
+
+		std::size_t regressions = 0;
+		std::size_t missing = 0;
+
+		for (const auto& result : candidate.results)
+		{
+			const auto found = before.find(result.name);
+
+			if (found == std::end(before))
+			{
+				std::cout << boost::format(u8"%1$-32s (new)") % result.name << std::endl;
+				continue;
+			}
+
+			const auto a = normalize(*found->second);
+			const auto b = normalize(result);
+			const auto baseWork = found->second->work;
+
+			before.erase(found);
+
+			// A result without timings is an exact count, such as the code size in the quality suite:
+			// a status must not change, and any other count must not grow.
+			if (a.empty() && b.empty())
+			{
+				std::string verdict = u8"~";
+
+				if (result.unit == u8"status" ? result.work != baseWork : result.work > baseWork)
+				{
+					verdict = u8"REGRESSION";
+					regressions++;
+				}
+				else if (result.work < baseWork)
+				{
+					verdict = u8"improvement";
+				}
+
+				std::cout
+					<< boost::format(u8"%1$-32s %2$12d %3$12d %4$9s %5$21s %6$8s  %7%")
+						% result.name % baseWork % result.work % u8"" % u8"" % u8"" % verdict
+					<< std::endl;
+				continue;
+			}
+
+			if (a.empty() || b.empty())
+			{
+				std::cout << boost::format(u8"%1$-32s (no samples)") % result.name << std::endl;
+				missing++;
+				continue;
+			}
+
+			const auto m1 = median(a);
+			const auto m2 = median(b);
+			const auto delta = m2 / std::max(m1, 1e-300) - 1.0;
+			const auto [low, high] = bootstrap(a, b, options);
+			const auto p = mannWhitney(a, b);
+			const auto significant = p < 1.0 - options.confidence;
+
+			std::string verdict = u8"~";
+
+			if (significant && low > options.threshold)
+			{
+				verdict = u8"REGRESSION";
+				regressions++;
+			}
+			else if (significant && high < -options.threshold)
+			{
+				verdict = u8"improvement";
+			}
+
+			std::cout
+				<< boost::format(u8"%1$-32s %2$12.3f %3$12.3f %4$+8.2f%% [%5$+8.2f%%, %6$+8.2f%%] %7$8.4f  %8%")
+					% result.name % (m1 * 1e9) % (m2 * 1e9) % (delta * 100) % (low * 100) % (high * 100) % p % verdict
+				<< std::endl;
+		}
+
+		for (const auto& [name, result] : before)
+		{
+			std::cout << boost::format(u8"%1$-32s (missing)") % name << std::endl;
+			missing++;
+		}
+
+		if (regressions > 0)
+		{
+			std::cout << boost::format(u8"%1% significant regression(s) above %2$.1f%%.") % regressions % (options.threshold * 100) << std::endl;
+		}
+
+		if (missing > 0 && !options.allowMissing)
+		{
+			std::cout << boost::format(u8"%1% benchmark(s) missing or without samples.") % missing << std::endl;
+		}
+
+		if (regressions > 0 || (missing > 0 && !options.allowMissing))
+		{
+			return 1;
+		}
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+
+		return 1;
+	}
+}
@@ -0,0 +1,240 @@
+/*================================================================================
+ * The MIT License
+ *
+ * Copyright (c) 2018 Ryooooooga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+================================================================================*/
+
+#include "Benchmark.hpp"
+#include "ProgramGenerator.hpp"
+
+#include "meteor/cc/Compiler.hpp"
+#include "meteor/cc/Lexer.hpp"
+#include "meteor/cc/Parser.hpp"
+#include "meteor/cc/SymbolAnalyzer.hpp"
+
+#include <iostream>
+
+namespace
+{
+	[[nodiscard]]
+	std::uint64_t countNodes(const meteor::cc::Node& node) noexcept
+	{
+		std::uint64_t count = 1;
+
+		for (const auto& child : node.children())
+		{
+			if (child)
+			{
+				count += countNodes(*child);
+			}
+		}
+
+		return count;
+	}
+
+	[[nodiscard]]
+	std::unique_ptr<meteor::cc::RootNode> parse(const std::string& source)
+	{
+		return meteor::cc::Parser { u8"generated.c", source }.parse();
+	}
+
+	[[nodiscard]]
+	std::unique_ptr<meteor::cc::RootNode> resolve(const std::string& source)
+	{
+		auto ast = parse(source);
+
+		meteor::cc::SymbolAnalyzer {}.resolve(*ast);
+
+		return ast;
+	}
+
+	// One tree per pass, built outside the timed region.
+	template <typename Build>
+	[[nodiscard]]
+	std::vector<std::unique_ptr<meteor::cc::RootNode>> trees(std::size_t passes, Build build, const std::string& source)
+	{
+		std::vector<std::unique_ptr<meteor::cc::RootNode>> asts;
+
+		for (std::size_t pass = 0; pass < passes; pass++)
+		{
+			asts.emplace_back(build(source));
+		}
+
+		return asts;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	try
+	{
+		auto parameters = meteor::benchmark::ProgramGenerator::Parameters {};
+		std::uint64_t seed = 1;
+		std::size_t passes = 25;
+
+		const auto options = meteor::benchmark::parseOptions(argc, argv, [&](int i)
+		{
+			const std::string_view arg = argv[i];
+
+			if (i + 1 >= argc)
+			{
+				throw std::runtime_error { (boost::format(u8"unknown option `%1%'.") % arg).str() };
+			}
+			else if (arg == u8"--functions")
+			{
+				parameters.functions = std::stoul(argv[++i]);
+			}
+			else if (arg == u8"--statements")
+			{
+				parameters.statements = std::stoul(argv[++i]);
+			}
+			else if (arg == u8"--depth")
+			{
+				parameters.depth = std::stoul(argv[++i]);
+			}
+			else if (arg == u8"--nesting")
+			{
+				parameters.nesting = std::stoul(argv[++i]);
+			}
+			else if (arg == u8"--passes")
+			{
+				passes = std::max(std::stoul(argv[++i]), 1ul);
+			}
+			else if (arg == u8"--seed")
+			{
+				seed = std::stoull(argv[++i]);
+			}
+			else
+			{
+				throw std::runtime_error { (boost::format(u8"unknown option `%1%'.") % arg).str() };
+			}
+
+			return i;
+		});
+
+		const auto source = meteor::benchmark::ProgramGenerator { parameters, seed }.generate();
+
+		std::cout
+			<< boost::format(u8"program: %1% functions, %2% statements, depth %3%, nesting %4%, %5% bytes, %6% passes")
+				% parameters.functions % parameters.statements % parameters.depth % parameters.nesting % source.size() % passes
+			<< std::endl;
+
+		auto results = meteor::benchmark::ResultSet { u8"compiler", {} };
+
+		meteor::benchmark::printHeader(std::cout);
+
+		// Lexing alone; the parser lexes on demand, so its time includes lexing.
+		if (options.selected(u8"lex"))
+		{
+			const auto lex = [&](int)
+			{
+				std::uint64_t tokens = 0;
+
+				for (std::size_t pass = 0; pass < passes; pass++)
+				{
+					auto lexer = meteor::cc::Lexer { u8"generated.c", source };
+
+					tokens++;
+
+					while (lexer.read()->kind() != meteor::cc::TokenKind::endOfFile)
+					{
+						tokens++;
+					}
+				}
+
+				return tokens;
+			};
+
+			results.results.emplace_back(meteor::benchmark::measure(options, u8"lex", u8"token", [] { return 0; }, lex));
+
+			meteor::benchmark::print(std::cout, results.results.back());
+		}
+
+		if (options.selected(u8"parse"))
+		{
+			const auto run = [&](int)
+			{
+				std::uint64_t nodes = 0;
+
+				for (std::size_t pass = 0; pass < passes; pass++)
+				{
+					nodes += countNodes(*parse(source));
+				}
+
+				return nodes;
+			};
+
+			results.results.emplace_back(meteor::benchmark::measure(options, u8"parse", u8"node", [] { return 0; }, run));
+
+			meteor::benchmark::print(std::cout, results.results.back());
+		}
+
+		if (options.selected(u8"resolve"))
+		{
+			const auto run = [&](std::vector<std::unique_ptr<meteor::cc::RootNode>>& asts)
+			{
+				std::uint64_t nodes = 0;
+
+				for (auto& ast : asts)
+				{
+					meteor::cc::SymbolAnalyzer {}.resolve(*ast);
+
+					nodes += countNodes(*ast);
+				}
+
+				return nodes;
+			};
+
+			results.results.emplace_back(meteor::benchmark::measure(options, u8"resolve", u8"node", [&] { return trees(passes, parse, source); }, run));
+
+			meteor::benchmark::print(std::cout, results.results.back());
+		}
+
+		if (options.selected(u8"compile"))
+		{
+			const auto run = [&](std::vector<std::unique_ptr<meteor::cc::RootNode>>& asts)
+			{
+				std::uint64_t words = 0;
+
+				for (auto& ast : asts)
+				{
+					words += meteor::cc::Compiler {}.compile(*ast).size();
+				}
+
+				return words;
+			};
+
+			results.results.emplace_back(meteor::benchmark::measure(options, u8"compile", u8"word", [&] { return trees(passes, resolve, source); }, run));
+
+			meteor::benchmark::print(std::cout, results.results.back());
+		}
+
+		meteor::benchmark::save(options, results);
+
+		std::cout << boost::format(u8"peak RSS: %1% KiB") % meteor::benchmark::peakResidentSetSize() << std::endl;
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+
+		return 1;
+	}
+}
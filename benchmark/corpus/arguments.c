@@ -0,0 +1,29 @@
+// Calls with several arguments and nested calls as arguments.
+int add3(int a, int b, int c) {
+	return a + b + c;
+}
+
+int pick(int a, int b, int c, int d) {
+	int x;
+	int y;
+
+	x = a - b;
+	y = c - d;
+
+	return add3(x, y, a + d);
+}
+
+int main(void) {
+	int i;
+	int s;
+
+	s = 0;
+	i = 500;
+
+	while (i) {
+		s = s + pick(add3(i, 1, 2), i, -i, add3(1, 2, 3));
+		i = i - 1;
+	}
+
+	return s;
+}
@@ -0,0 +1,18 @@
+// Additions and subtractions on locals.
+int main(void) {
+	int i;
+	int x;
+	int y;
+
+	x = 0;
+	y = 1;
+	i = 2000;
+
+	while (i) {
+		x = x + y;
+		y = x - y;
+		i = i - 1;
+	}
+
+	return x;
+}
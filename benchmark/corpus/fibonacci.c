@@ -0,0 +1,16 @@
+// Recursive calls with a shallow frame.
+int fib(int n) {
+	if (n) {
+		if (n - 1) {
+			return fib(n - 1) + fib(n - 2);
+		}
+
+		return 1;
+	}
+
+	return 0;
+}
+
+int main(void) {
+	return fib(18);
+}
@@ -0,0 +1,28 @@
+// Indirect calls through function pointers.
+int increment(int x) {
+	return x + 1;
+}
+
+int decrement(int x) {
+	return x - 1;
+}
+
+int main(void) {
+	int (*up)(int y);
+	int (*down)(int y);
+	int i;
+	int s;
+
+	up = &increment;
+	down = &decrement;
+	s = 0;
+	i = 1000;
+
+	while (i) {
+		s = (*up)((*up)(s));
+		s = (*down)(s);
+		i = i - 1;
+	}
+
+	return s;
+}
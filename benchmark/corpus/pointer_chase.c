@@ -0,0 +1,24 @@
+// Loads and stores through a chain of pointers.
+int main(void) {
+	int a;
+	int *b;
+	int **c;
+	int ***d;
+	int n;
+	int s;
+
+	a = 3;
+	b = &a;
+	c = &b;
+	d = &c;
+	s = 0;
+	n = 2000;
+
+	while (n) {
+		s = s + ***d;
+		**d = &a;
+		n = n - 1;
+	}
+
+	return s;
+}
@@ -0,0 +1,12 @@
+// Deep recursion: one frame per element.
+int sum(int n) {
+	if (n) {
+		return n + sum(n - 1);
+	}
+
+	return 0;
+}
+
+int main(void) {
+	return sum(300);
+}
@@ -0,0 +1,476 @@
+/*================================================================================
+ * The MIT License
+ *
+ * Copyright (c) 2018 Ryooooooga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+================================================================================*/
+
+#include "Benchmark.hpp"
+
+#include "meteor/cc/Compiler.hpp"
+#include "meteor/cc/Parser.hpp"
+#include "meteor/cc/SymbolAnalyzer.hpp"
+#include "meteor/runtime/Network.hpp"
+#include "meteor/runtime/Processor.hpp"
+#include "meteor/runtime/Profiler.hpp"
+#include "meteor/runtime/SamplingProfiler.hpp"
+#include "meteor/runtime/SystemCallLog.hpp"
+#include "meteor/SystemCall.hpp"
+
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+namespace
+{
+	using meteor::Register;
+	using meteor::Word;
+
+	// Recursive calls.
+	constexpr char fibonacciSource[] = u8R"(
+		int fib(int n) {
+			if (n) {
+				if (n - 1) {
+					return fib(n - 1) + fib(n - 2);
+				}
+
+				return 1;
+			}
+
+			return 0;
+		}
+
+		int main(void) {
+			return fib(24);
+		}
+	)";
+
+	// Loads through a chain of pointers.
+	constexpr char pointerChaseSource[] = u8R"(
+		int main(void) {
+			int a;
+			int *b;
+			int **c;
+			int ***d;
+			int i;
+			int n;
+			int s;
+
+			a = 3;
+			b = &a;
+			c = &b;
+			d = &c;
+			s = 0;
+			i = 10;
+
+			while (i) {
+				n = 30000;
+
+				while (n) {
+					s = s + ***d;
+					**d = &a;
+					n = n - 1;
+				}
+
+				i = i - 1;
+			}
+
+			return s;
+		}
+	)";
+
+	// Additions and subtractions on locals.
+	constexpr char arithmeticSource[] = u8R"(
+		int main(void) {
+			int i;
+			int j;
+			int x;
+			int y;
+
+			x = 0;
+			y = 1;
+			i = 10;
+
+			while (i) {
+				j = 30000;
+
+				while (j) {
+					x = x + y;
+					y = x - y;
+					j = j - 1;
+				}
+
+				i = i - 1;
+			}
+
+			return x;
+		}
+	)";
+
+	[[nodiscard]]
+	std::vector<Word> compile(std::string_view name, std::string_view source)
+	{
+		auto parser = meteor::cc::Parser { name, source };
+		auto ast = parser.parse();
+
+		meteor::cc::SymbolAnalyzer {}.resolve(*ast);
+
+		return meteor::cc::Compiler {}.compile(*ast);
+	}
+
+	// The C subset cannot issue system calls, so the I/O workload is assembled by hand:
+	// it writes a 32-character buffer 20000 times.
+	[[nodiscard]]
+	std::vector<Word> assembleOutput()
+	{
+		namespace op = meteor::operations;
+
+		constexpr Word loop = 0x0004;
+		constexpr Word buffer = 0x0013;
+		constexpr Word length = 32;
+
+		std::vector<Word> image {
+			op::instruction(op::lad, Register::general0, Register::general0), 0x0000,
+			op::instruction(op::lad, Register::general4, Register::general0), 20000,
+			// loop:
+			op::instruction(op::lad, Register::general1, Register::general0), buffer,
+			op::instruction(op::lad, Register::general2, Register::general0), length,
+			op::instruction(op::svc, Register::general0, Register::general0), meteor::system_calls::write,
+			op::instruction(op::lad, Register::general4, Register::general4), 0xffff,
+			op::instruction(op::ld_r, Register::general4, Register::general4),
+			op::instruction(op::jnz, Register::general0, Register::general0), loop,
+			op::instruction(op::lad, Register::general1, Register::general0), 0x0000,
+			op::instruction(op::svc, Register::general0, Register::general0), meteor::system_calls::exit,
+		};
+
+		for (Word i = 0; i < length; i++)
+		{
+			image.emplace_back(static_cast<Word>(u8'a' + i % 26));
+		}
+
+		return image;
+	}
+
+	// Messages passed from the producer to the consumer node of the channel workloads.
+	constexpr Word messages = 60000;
+
+	// Sends messages, messages - 1, ..., 1 on port 0.
+	[[nodiscard]]
+	std::vector<Word> assembleProducer()
+	{
+		namespace op = meteor::operations;
+
+		constexpr Word loop = 0x0004;
+
+		return {
+			op::instruction(op::lad, Register::general0, Register::general0), 0x0000,
+			op::instruction(op::lad, Register::general4, Register::general0), messages,
+			// loop:
+			op::instruction(op::lad, Register::general1, Register::general0), 0x0000,
+			op::instruction(op::ld_r, Register::general2, Register::general4),
+			op::instruction(op::svc, Register::general0, Register::general0), meteor::system_calls::send,
+			op::instruction(op::lad, Register::general4, Register::general4), 0xffff,
+			op::instruction(op::ld_r, Register::general4, Register::general4),
+			op::instruction(op::jnz, Register::general0, Register::general0), loop,
+			op::instruction(op::lad, Register::general1, Register::general0), 0x0000,
+			op::instruction(op::svc, Register::general0, Register::general0), meteor::system_calls::exit,
+		};
+	}
+
+	// Receives `messages' words on port 0 and exits with their sum modulo 65536.
+	[[nodiscard]]
+	std::vector<Word> assembleConsumer()
+	{
+		namespace op = meteor::operations;
+
+		constexpr Word loop = 0x0006;
+
+		return {
+			op::instruction(op::lad, Register::general0, Register::general0), 0x0000,
+			op::instruction(op::lad, Register::general4, Register::general0), messages,
+			op::instruction(op::lad, Register::general5, Register::general0), 0x0000,
+			// loop:
+			op::instruction(op::lad, Register::general1, Register::general0), 0x0000,
+			op::instruction(op::svc, Register::general0, Register::general0), meteor::system_calls::receive,
+			op::instruction(op::addl_r, Register::general5, Register::general1),
+			op::instruction(op::lad, Register::general4, Register::general4), 0xffff,
+			op::instruction(op::ld_r, Register::general4, Register::general4),
+			op::instruction(op::jnz, Register::general0, Register::general0), loop,
+			op::instruction(op::ld_r, Register::general1, Register::general5),
+			op::instruction(op::svc, Register::general0, Register::general0), meteor::system_calls::exit,
+		};
+	}
+
+	struct Workload
+	{
+		std::string name;
+		std::vector<Word> image;
+		Word exitStatus;
+	};
+}
+
+int main(int argc, char* argv[])
+{
+	try
+	{
+		const auto options = meteor::benchmark::parseOptions(argc, argv);
+
+		const std::vector<Workload> workloads {
+			{ u8"recursive-calls", compile(u8"fibonacci.c", fibonacciSource), 46368 },
+			{ u8"pointer-chase", compile(u8"pointer-chase.c", pointerChaseSource), 48032 },
+			{ u8"arithmetic-loop", compile(u8"arithmetic.c", arithmeticSource), 16000 },
+			{ u8"output", assembleOutput(), 0 },
+		};
+
+		meteor::benchmark::NullBuffer nullBuffer;
+		std::ostream null { &nullBuffer };
+
+		auto results = meteor::benchmark::ResultSet { u8"guest", {} };
+
+		meteor::benchmark::printHeader(std::cout);
+
+		for (const auto& workload : workloads)
+		{
+			if (!options.selected(workload.name))
+			{
+				continue;
+			}
+
+			const auto prepare = [&]
+			{
+				auto processor = meteor::runtime::Processor { std::make_shared<meteor::runtime::Memory>(workload.image) };
+
+				processor.output(null);
+
+				return processor;
+			};
+
+			const auto run = [&](meteor::runtime::Processor& processor)
+			{
+				processor.run(std::numeric_limits<std::uint64_t>::max());
+
+				if (processor.exitStatus() != workload.exitStatus)
+				{
+					throw std::runtime_error { workload.name + u8": unexpected exit status." };
+				}
+
+				return processor.steps();
+			};
+
+			results.results.emplace_back(meteor::benchmark::measure(options, workload.name, u8"step", prepare, run));
+
+			meteor::benchmark::print(std::cout, results.results.back());
+		}
+
+		// Profiling overhead on the compiled workloads: the exact per-address Profiler observes every
+		// instruction, the SamplingProfiler runs the plain processor in slices of about 1000 instructions.
+		for (const auto& workload : workloads)
+		{
+			if (workload.name == u8"output")
+			{
+				continue;
+			}
+
+			const auto check = [&](const auto& processor)
+			{
+				if (processor.exitStatus() != workload.exitStatus)
+				{
+					throw std::runtime_error { workload.name + u8": unexpected exit status." };
+				}
+
+				return processor.steps();
+			};
+
+			if (const auto name = workload.name + u8"+profile"; options.selected(name))
+			{
+				auto profiler = meteor::runtime::Profiler {};
+
+				const auto prepare = [&]
+				{
+					auto processor = meteor::runtime::BasicProcessor { std::make_shared<meteor::runtime::Memory>(workload.image), profiler };
+
+					processor.output(null);
+
+					return processor;
+				};
+
+				const auto run = [&](meteor::runtime::BasicProcessor<meteor::runtime::Profiler>& processor)
+				{
+					processor.run(std::numeric_limits<std::uint64_t>::max());
+
+					return check(processor);
+				};
+
+				results.results.emplace_back(meteor::benchmark::measure(options, name, u8"step", prepare, run));
+
+				meteor::benchmark::print(std::cout, results.results.back());
+			}
+
+			if (const auto name = workload.name + u8"+sample"; options.selected(name))
+			{
+				const auto prepare = [&]
+				{
+					auto processor = meteor::runtime::Processor { std::make_shared<meteor::runtime::Memory>(workload.image) };
+
+					processor.output(null);
+
+					return processor;
+				};
+
+				const auto run = [&](meteor::runtime::Processor& processor)
+				{
+					auto profiler = meteor::runtime::SamplingProfiler { 1000 };
+
+					profiler.run(processor, std::numeric_limits<std::uint64_t>::max());
+
+					return check(processor);
+				};
+
+				results.results.emplace_back(meteor::benchmark::measure(options, name, u8"step", prepare, run));
+
+				meteor::benchmark::print(std::cout, results.results.back());
+			}
+		}
+
+		// System call record and replay: recording appends every system call to a log, replaying serves
+		// them from a log recorded beforehand instead of the host streams.
+		for (const auto& workload : workloads)
+		{
+			const auto check = [&](meteor::runtime::Processor& processor)
+			{
+				processor.run(std::numeric_limits<std::uint64_t>::max());
+
+				if (processor.exitStatus() != workload.exitStatus)
+				{
+					throw std::runtime_error { workload.name + u8": unexpected exit status." };
+				}
+
+				return processor.steps();
+			};
+
+			const auto processor = [&]
+			{
+				auto processor = meteor::runtime::Processor { std::make_shared<meteor::runtime::Memory>(workload.image) };
+
+				processor.output(null);
+
+				return processor;
+			};
+
+			if (const auto name = workload.name + u8"+record"; options.selected(name))
+			{
+				const auto prepare = [&]
+				{
+					auto p = processor();
+
+					p.record(std::make_shared<meteor::runtime::SystemCallLog>());
+
+					return p;
+				};
+
+				results.results.emplace_back(meteor::benchmark::measure(options, name, u8"step", prepare, check));
+
+				meteor::benchmark::print(std::cout, results.results.back());
+			}
+
+			if (const auto name = workload.name + u8"+replay"; options.selected(name))
+			{
+				std::stringstream recorded;
+
+				{
+					auto log = std::make_shared<meteor::runtime::SystemCallLog>();
+					auto p = processor();
+
+					p.record(log);
+					check(p);
+					log->save(recorded);
+				}
+
+				const auto prepare = [&]
+				{
+					auto p = processor();
+					std::istringstream stream { recorded.str() };
+
+					p.replay(std::make_shared<meteor::runtime::SystemCallLog>(meteor::runtime::SystemCallLog::load(stream)));
+
+					return p;
+				};
+
+				results.results.emplace_back(meteor::benchmark::measure(options, name, u8"step", prepare, check));
+
+				meteor::benchmark::print(std::cout, results.results.back());
+			}
+		}
+
+		// Message passing between two nodes through a channel, on one worker (every full or empty
+		// channel parks a node) and on two workers.
+		for (const std::size_t workers : { 1, 2 })
+		{
+			const auto name = (boost::format(u8"channel-%1%-worker%2%") % workers % (workers > 1 ? u8"s" : u8"")).str();
+
+			if (!options.selected(name))
+			{
+				continue;
+			}
+
+			const auto producer = assembleProducer();
+			const auto consumer = assembleConsumer();
+
+			const auto prepare = [&]
+			{
+				auto network = std::make_unique<meteor::runtime::Network>(workers);
+
+				network->addNode(std::make_shared<meteor::runtime::Memory>(producer));
+				network->addNode(std::make_shared<meteor::runtime::Memory>(consumer));
+				network->connect(0, 0, 1, 0);
+				network->processor(0).output(null);
+				network->processor(1).output(null);
+
+				return network;
+			};
+
+			const auto run = [&](std::unique_ptr<meteor::runtime::Network>& network)
+			{
+				const auto sum = static_cast<Word>(std::uint64_t {messages} * (messages + 1) / 2);
+
+				if (!network->run(std::numeric_limits<std::uint64_t>::max()) || network->processor(1).exitStatus() != sum)
+				{
+					throw std::runtime_error { name + u8": unexpected exit status." };
+				}
+
+				return std::uint64_t {messages};
+			};
+
+			results.results.emplace_back(meteor::benchmark::measure(options, name, u8"msg", prepare, run));
+
+			meteor::benchmark::print(std::cout, results.results.back());
+		}
+
+		meteor::benchmark::save(options, results);
+
+		std::cout << boost::format(u8"peak RSS: %1% KiB") % meteor::benchmark::peakResidentSetSize() << std::endl;
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+
+		return 1;
+	}
+}
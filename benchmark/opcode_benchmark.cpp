@@ -0,0 +1,354 @@
+/*================================================================================
+ * The MIT License
+ *
+ * Copyright (c) 2018 Ryooooooga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+================================================================================*/
+
+#include "Benchmark.hpp"
+
+#include "meteor/runtime/Processor.hpp"
+#include "meteor/SystemCall.hpp"
+
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <sstream>
+
+#ifdef __linux__
+#	include <linux/perf_event.h>
+#	include <sys/syscall.h>
+#	include <unistd.h>
+#endif
+
+namespace
+{
+	using meteor::Register;
+	using meteor::Word;
+
+	namespace op = meteor::operations;
+
+	// CPU cycles of the calling thread from perf_event_open, when the kernel permits it.
+	class HardwareCycles
+	{
+	public:
+		explicit HardwareCycles()
+			: m_fd(-1)
+		{
+#ifdef __linux__
+			perf_event_attr attributes;
+
+			std::memset(&attributes, 0, sizeof(attributes));
+			attributes.type = PERF_TYPE_HARDWARE;
+			attributes.size = sizeof(attributes);
+			attributes.config = PERF_COUNT_HW_CPU_CYCLES;
+			attributes.exclude_kernel = 1;
+			attributes.exclude_hv = 1;
+
+			m_fd = static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+#endif
+		}
+
+		// Uncopyable, unmovable.
+		HardwareCycles(const HardwareCycles&) =delete;
+		HardwareCycles(HardwareCycles&&) =delete;
+
+		HardwareCycles& operator=(const HardwareCycles&) =delete;
+		HardwareCycles& operator=(HardwareCycles&&) =delete;
+
+		~HardwareCycles()
+		{
+#ifdef __linux__
+			if (m_fd >= 0)
+			{
+				close(m_fd);
+			}
+#endif
+		}
+
+		[[nodiscard]]
+		bool available() const noexcept
+		{
+			return m_fd >= 0;
+		}
+
+		[[nodiscard]]
+		std::uint64_t read() const noexcept
+		{
+			std::uint64_t cycles = 0;
+
+#ifdef __linux__
+			if (m_fd < 0 || ::read(m_fd, &cycles, sizeof(cycles)) != sizeof(cycles))
+			{
+				return 0;
+			}
+#endif
+
+			return cycles;
+		}
+
+	private:
+		int m_fd;
+	};
+
+	constexpr Word subroutine = 0xf000;
+	constexpr Word data = 0xf100;
+
+	// One measured unit: the words of its instructions at `address', and how many instructions it retires.
+	struct Case
+	{
+		std::string name;
+		std::function<std::vector<Word>(Word address)> unit;
+		std::uint64_t instructions;
+	};
+
+	[[nodiscard]]
+	Case single(std::string name, Word operation, Register r1, Register r2, std::optional<Word> operand = std::nullopt)
+	{
+		return Case { std::move(name), [=](Word)
+		{
+			return operand ? std::vector<Word> { op::instruction(operation, r1, r2), *operand } : std::vector<Word> { op::instruction(operation, r1, r2) };
+		}, 1 };
+	}
+
+	[[nodiscard]]
+	std::vector<Case> cases()
+	{
+		const auto gr1 = Register::general1;
+		const auto gr2 = Register::general2;
+		const auto gr0 = Register::general0;
+
+		return {
+			single(u8"NOP", op::nop, gr0, gr0),
+			single(u8"LD r,adr", op::ld_adr, gr1, gr0, data),
+			single(u8"ST", op::st, gr1, gr0, data),
+			single(u8"LAD", op::lad, gr1, gr0, 0x0001),
+			single(u8"LD r,r", op::ld_r, gr1, gr2),
+			single(u8"ADDA r,adr", op::adda_adr, gr1, gr0, data),
+			single(u8"ADDA r,r", op::adda_r, gr1, gr2),
+			single(u8"SUBA r,r", op::suba_r, gr1, gr2),
+			single(u8"ADDL r,r", op::addl_r, gr1, gr2),
+			single(u8"SUBL r,r", op::subl_r, gr1, gr2),
+			single(u8"AND r,r", op::and_r, gr1, gr2),
+			single(u8"OR r,r", op::or_r, gr1, gr2),
+			single(u8"XOR r,r", op::xor_r, gr1, gr2),
+			single(u8"CPA r,r", op::cpa_r, gr1, gr2),
+			single(u8"CPL r,r", op::cpl_r, gr1, gr2),
+			single(u8"SLA 1", op::sla_adr, gr1, gr0, 1),
+			single(u8"SRA 1", op::sra_adr, gr1, gr0, 1),
+			single(u8"SLL 1", op::sll_adr, gr1, gr0, 1),
+			single(u8"SRL 1", op::srl_adr, gr1, gr0, 1),
+			single(u8"SLL 15", op::sll_adr, gr1, gr0, 15),
+			// GR1 is never zero here, so JZE falls through.
+			single(u8"JZE not taken", op::jze, gr0, gr0, 0x0000),
+			Case { u8"JUMP taken", [=](Word address)
+			{
+				return std::vector<Word> { op::instruction(op::jump, gr0, gr0), static_cast<Word>(address + 2) };
+			}, 1 },
+			Case { u8"PUSH+POP", [=](Word)
+			{
+				return std::vector<Word> { op::instruction(op::push, gr0, gr0), 0x0001, op::instruction(op::pop, gr2, gr0) };
+			}, 2 },
+			Case { u8"CALL+RET", [=](Word)
+			{
+				return std::vector<Word> { op::instruction(op::call, gr0, gr0), subroutine };
+			}, 2 },
+		};
+	}
+
+	// Sets up the registers, repeats the unit `copies' times inside a loop of `iterations', then exits.
+	// With `iterations' 1 the image is straight-line code.
+	[[nodiscard]]
+	std::vector<Word> assemble(const Case& c, std::size_t copies, Word iterations)
+	{
+		std::vector<Word> image {
+			op::instruction(op::lad, Register::general0, Register::general0), 0x0000,
+			op::instruction(op::lad, Register::general1, Register::general0), 0x0003,
+			op::instruction(op::lad, Register::general2, Register::general0), 0x0001,
+			op::instruction(op::lad, Register::general6, Register::general0), iterations,
+		};
+
+		const auto loop = static_cast<Word>(image.size());
+
+		for (std::size_t i = 0; i < copies; i++)
+		{
+			const auto words = c.unit(static_cast<Word>(image.size()));
+
+			image.insert(std::end(image), std::begin(words), std::end(words));
+		}
+
+		const std::vector<Word> epilogue {
+			op::instruction(op::lad, Register::general6, Register::general6), 0xffff,
+			op::instruction(op::ld_r, Register::general6, Register::general6),
+			op::instruction(op::jnz, Register::general0, Register::general0), loop,
+			op::instruction(op::svc, Register::general0, Register::general0), meteor::system_calls::exit,
+		};
+
+		image.insert(std::end(image), std::begin(epilogue), std::end(epilogue));
+
+		if (image.size() > subroutine)
+		{
+			throw std::runtime_error { c.name + u8": image too large." };
+		}
+
+		image.resize(data + 1, 0);
+		image[subroutine] = op::ret;
+
+		return image;
+	}
+
+	struct Timing
+	{
+		double nanoseconds;
+		double cycles;
+		// Each repetition's time for the unit instructions alone, for the result file.
+		meteor::benchmark::Result result;
+	};
+
+	// Median time and cycles per unit instruction, after subtracting the same image without the units.
+	[[nodiscard]]
+	Timing time(const meteor::benchmark::Options& options, const HardwareCycles& counter, const Case& c, std::size_t copies, Word iterations, std::size_t runs)
+	{
+		const auto measure = [&](const std::vector<Word>& image)
+		{
+			auto memory = std::make_shared<meteor::runtime::Memory>(image);
+			auto processor = meteor::runtime::Processor { memory };
+			std::ostringstream output;
+
+			processor.output(output);
+
+			std::vector<double> seconds;
+			std::vector<double> cycles;
+
+			for (std::size_t r = 0; r < options.warmup + options.repetitions; r++)
+			{
+				const auto startCycles = counter.read();
+				const auto start = std::chrono::steady_clock::now();
+
+				for (std::size_t i = 0; i < runs; i++)
+				{
+					processor.reset();
+					processor.run(std::numeric_limits<std::uint64_t>::max());
+				}
+
+				const auto elapsed = std::chrono::duration<double> { std::chrono::steady_clock::now() - start }.count();
+
+				if (r >= options.warmup)
+				{
+					seconds.emplace_back(elapsed);
+					cycles.emplace_back(static_cast<double>(counter.read() - startCycles));
+				}
+			}
+
+			auto result = meteor::benchmark::Result { {}, u8"instr", 0, seconds };
+
+			std::sort(std::begin(seconds), std::end(seconds));
+			std::sort(std::begin(cycles), std::end(cycles));
+
+			return Timing { seconds[seconds.size() / 2] * 1e9, cycles[cycles.size() / 2], std::move(result) };
+		};
+
+		const auto full = measure(assemble(c, copies, iterations));
+		const auto empty = measure(assemble(c, 0, iterations));
+		const auto instructions = static_cast<double>(runs) * iterations * copies * c.instructions;
+
+		auto result = full.result;
+
+		result.work = static_cast<std::uint64_t>(instructions);
+
+		for (auto& seconds : result.seconds)
+		{
+			seconds -= empty.nanoseconds / 1e9;
+		}
+
+		return Timing { (full.nanoseconds - empty.nanoseconds) / instructions, (full.cycles - empty.cycles) / instructions, std::move(result) };
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	try
+	{
+		const auto options = meteor::benchmark::parseOptions(argc, argv);
+		const HardwareCycles counter {};
+
+		if (!counter.available())
+		{
+			std::cout << u8"note: hardware cycle counters are not available; only times are reported." << std::endl;
+		}
+
+		std::cout
+			<< boost::format(u8"%1$-16s %2$14s %3$14s %4$12s %5$12s")
+				% u8"instruction" % u8"straight ns" % u8"loop ns" % u8"loop - NOP" % u8"cycles"
+			<< std::endl;
+
+		auto results = meteor::benchmark::ResultSet { u8"opcodes", {} };
+		std::optional<double> nop;
+
+		for (const auto& c : cases())
+		{
+			if (!options.selected(c.name) && c.name != u8"NOP")
+			{
+				continue;
+			}
+
+			// Straight-line code: one pass over as many copies as fit, repeated.
+			const auto copies = static_cast<std::size_t>(0xe000 / c.unit(0).size());
+			auto straight = time(options, counter, c, copies, 1, 50);
+			// A loop over 64 copies, small enough to stay in the host caches.
+			auto looped = time(options, counter, c, 64, 20000, 2);
+
+			if (!nop)
+			{
+				nop = looped.nanoseconds;
+			}
+
+			if (!options.selected(c.name))
+			{
+				continue;
+			}
+
+			std::cout
+				<< boost::format(u8"%1$-16s %2$14.2f %3$14.2f %4$12.2f %5$12s")
+					% c.name
+					% straight.nanoseconds
+					% looped.nanoseconds
+					% (looped.nanoseconds - *nop)
+					% (counter.available() ? (boost::format(u8"%1$.1f") % looped.cycles).str() : std::string { u8"-" })
+				<< std::endl;
+
+			straight.result.name = c.name + u8"/straight";
+			looped.result.name = c.name + u8"/loop";
+
+			results.results.emplace_back(std::move(straight.result));
+			results.results.emplace_back(std::move(looped.result));
+		}
+
+		meteor::benchmark::save(options, results);
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+
+		return 1;
+	}
+}
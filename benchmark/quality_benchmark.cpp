@@ -0,0 +1,354 @@
+/*================================================================================
+ * The MIT License
+ *
+ * Copyright (c) 2018 Ryooooooga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+================================================================================*/
+
+// meteor_bench_quality [--corpus DIR] [--baseline FILE] [--budget N] [--warmup N] [--repetitions N] [--filter NAME] [--json FILE]
+// Compiles each program of the corpus, runs it to exit and records the quality of the emitted code.
+// Every program yields a timed result `NAME/VARIANT' whose work is its step count, and the counts
+// `NAME/VARIANT/image', `/stack', `/frame' (words) and `/exit' (status), without timings.
+// Exits with 1 when a count grows or an exit status changes against the baseline, which defaults
+// to baseline.json in the corpus; refresh it with --json when the code generator improves.
+
+#include "Benchmark.hpp"
+
+#include "meteor/cc/Compiler.hpp"
+#include "meteor/cc/Parser.hpp"
+#include "meteor/cc/SymbolAnalyzer.hpp"
+#include "meteor/runtime/Processor.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <optional>
+#include <sstream>
+
+namespace
+{
+	using meteor::Register;
+	using meteor::Word;
+
+	// Code generation settings to compare; every program is compiled with each of them.
+	struct Variant
+	{
+		std::string name;
+		std::function<std::vector<Word>(meteor::cc::RootNode&)> compile;
+	};
+
+	[[nodiscard]]
+	std::vector<Variant> variants()
+	{
+		return {
+			{ u8"default", [](meteor::cc::RootNode& ast) { return meteor::cc::Compiler {}.compile(ast); } },
+		};
+	}
+
+	struct Metrics
+	{
+		std::string name;
+		Word exitStatus;
+		// Words in the image.
+		std::uint64_t image;
+		std::uint64_t steps;
+		// High-water marks of the hardware stack below 0x10000 and of the frame pointer GR7 above the image.
+		std::uint64_t stack;
+		std::uint64_t frame;
+	};
+
+	class DepthObserver
+		: public meteor::runtime::NullObserver
+	{
+	public:
+		explicit DepthObserver(Word frameBase) noexcept
+			: m_frameBase(frameBase)
+		{
+		}
+
+		template <typename Processor>
+		void onRetire(const Processor& processor) noexcept
+		{
+			const auto sp = processor.getRegister(Register::stackPointer);
+			const auto fp = processor.getRegister(Register::general7);
+
+			m_stack = std::max(m_stack, static_cast<Word>(0 - sp));
+
+			if (fp >= m_frameBase)
+			{
+				m_frame = std::max(m_frame, static_cast<Word>(fp - m_frameBase));
+			}
+		}
+
+		[[nodiscard]]
+		Word stack() const noexcept
+		{
+			return m_stack;
+		}
+
+		[[nodiscard]]
+		Word frame() const noexcept
+		{
+			return m_frame;
+		}
+
+	private:
+		Word m_frameBase;
+		Word m_stack = 0;
+		Word m_frame = 0;
+	};
+
+	[[nodiscard]]
+	std::string readFile(const std::filesystem::path& path)
+	{
+		std::ifstream stream { path };
+
+		if (!stream)
+		{
+			throw std::runtime_error { (boost::format(u8"cannot open `%1%'.") % path.string()).str() };
+		}
+
+		return std::string { std::istreambuf_iterator<char> { stream }, std::istreambuf_iterator<char> {} };
+	}
+
+	// Compiles the program and runs it once under the depth observer; returns its metrics and image.
+	[[nodiscard]]
+	std::pair<Metrics, std::vector<Word>> measure(const std::string& name, const std::string& source, const Variant& variant, std::uint64_t budget)
+	{
+		auto ast = meteor::cc::Parser { name, source }.parse();
+
+		meteor::cc::SymbolAnalyzer {}.resolve(*ast);
+
+		const auto image = variant.compile(*ast);
+
+		if (image.size() > 0x10000)
+		{
+			throw std::runtime_error { name + u8": the image exceeds the 64K-word address space." };
+		}
+
+		auto observer = DepthObserver { static_cast<Word>(image.size()) };
+		auto processor = meteor::runtime::BasicProcessor { std::make_shared<meteor::runtime::Memory>(image), observer };
+		std::ostringstream output;
+
+		processor.output(output);
+		processor.run(budget);
+
+		if (!processor.exitStatus())
+		{
+			throw std::runtime_error { (boost::format(u8"%1%: no exit within %2% steps.") % name % budget).str() };
+		}
+
+		return { Metrics { name + u8"/" + variant.name, *processor.exitStatus(), image.size(), processor.steps(), observer.stack(), observer.frame() }, image };
+	}
+
+	// The counts of a program, as results without timings.
+	[[nodiscard]]
+	std::vector<meteor::benchmark::Result> counts(const Metrics& m)
+	{
+		return {
+			{ m.name + u8"/image", u8"word", m.image, {} },
+			{ m.name + u8"/stack", u8"word", m.stack, {} },
+			{ m.name + u8"/frame", u8"word", m.frame, {} },
+			{ m.name + u8"/exit", u8"status", m.exitStatus, {} },
+		};
+	}
+
+	[[nodiscard]]
+	std::map<std::string, std::uint64_t> read(const std::string& path)
+	{
+		std::ifstream stream { path };
+
+		if (!stream)
+		{
+			throw std::runtime_error { (boost::format(u8"cannot open `%1%'.") % path).str() };
+		}
+
+		std::map<std::string, std::uint64_t> work;
+
+		for (const auto& result : meteor::benchmark::read(stream).results)
+		{
+			work.emplace(result.name, result.work);
+		}
+
+		return work;
+	}
+
+	// A metric and its change against the baseline, if any.
+	[[nodiscard]]
+	std::string compare(std::uint64_t value, const std::optional<std::uint64_t>& baseline)
+	{
+		if (!baseline || *baseline == value)
+		{
+			return std::to_string(value);
+		}
+
+		return (boost::format(u8"%1% (%2$+d)") % value % (static_cast<std::int64_t>(value) - static_cast<std::int64_t>(*baseline))).str();
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	try
+	{
+		std::string corpus = METEOR_BENCHMARK_CORPUS;
+		std::string baselinePath;
+		std::uint64_t budget = 100'000'000;
+
+		const auto options = meteor::benchmark::parseOptions(argc, argv, [&](int i)
+		{
+			const std::string_view arg = argv[i];
+
+			if (arg == u8"--corpus" && i + 1 < argc)
+			{
+				corpus = argv[++i];
+			}
+			else if (arg == u8"--baseline" && i + 1 < argc)
+			{
+				baselinePath = argv[++i];
+			}
+			else if (arg == u8"--budget" && i + 1 < argc)
+			{
+				budget = std::stoull(argv[++i]);
+			}
+			else
+			{
+				throw std::runtime_error { (boost::format(u8"unknown option `%1%'.") % arg).str() };
+			}
+
+			return i;
+		});
+
+		std::vector<std::filesystem::path> programs;
+
+		for (const auto& entry : std::filesystem::directory_iterator { corpus })
+		{
+			if (entry.path().extension() == u8".c" && options.selected(entry.path().stem().string()))
+			{
+				programs.emplace_back(entry.path());
+			}
+		}
+
+		std::sort(std::begin(programs), std::end(programs));
+
+		if (baselinePath.empty() && std::filesystem::exists(std::filesystem::path { corpus } / u8"baseline.json"))
+		{
+			baselinePath = (std::filesystem::path { corpus } / u8"baseline.json").string();
+		}
+
+		const auto baseline = baselinePath.empty() ? std::map<std::string, std::uint64_t> {} : read(baselinePath);
+
+		meteor::benchmark::NullBuffer nullBuffer;
+		std::ostream null { &nullBuffer };
+
+		auto results = meteor::benchmark::ResultSet { u8"quality", {} };
+		std::size_t regressions = 0;
+
+		std::cout
+			<< boost::format(u8"%1$-32s %2$8s %3$14s %4$18s %5$12s %6$12s %7$10s")
+				% u8"program" % u8"exit" % u8"image" % u8"steps" % u8"stack" % u8"frame" % u8"median ms"
+			<< std::endl;
+
+		for (const auto& path : programs)
+		{
+			const auto source = readFile(path);
+
+			for (const auto& variant : variants())
+			{
+				const auto [m, image] = measure(path.stem().string(), source, variant, budget);
+
+				const auto prepare = [&]
+				{
+					auto processor = meteor::runtime::Processor { std::make_shared<meteor::runtime::Memory>(image) };
+
+					processor.output(null);
+
+					return processor;
+				};
+
+				const auto run = [&](meteor::runtime::Processor& processor)
+				{
+					processor.run(budget);
+
+					return processor.steps();
+				};
+
+				const auto found = [&](const std::string& name) -> std::optional<std::uint64_t>
+				{
+					const auto it = baseline.find(name);
+
+					return it == std::end(baseline) ? std::nullopt : std::optional<std::uint64_t> { it->second };
+				};
+
+				auto programResults = counts(m);
+
+				programResults.insert(std::begin(programResults), meteor::benchmark::measure(options, m.name, u8"step", prepare, run));
+
+				// Counts never grow, and the exit status never changes.
+				bool known = false;
+				bool regressed = false;
+
+				for (const auto& result : programResults)
+				{
+					if (const auto before = found(result.name))
+					{
+						known = true;
+						regressed = regressed || (result.unit == u8"status" ? result.work != *before : result.work > *before);
+					}
+				}
+
+				std::cout
+					<< boost::format(u8"%1$-32s %2$8d %3$14s %4$18s %5$12s %6$12s %7$10.3f%8%")
+						% m.name
+						% m.exitStatus
+						% compare(m.image, found(m.name + u8"/image"))
+						% compare(m.steps, found(m.name))
+						% compare(m.stack, found(m.name + u8"/stack"))
+						% compare(m.frame, found(m.name + u8"/frame"))
+						% (programResults.front().median() * 1e3)
+						% (regressed ? u8"  REGRESSION" : known ? u8"" : baseline.empty() ? u8"" : u8"  (new)")
+					<< std::endl;
+
+				if (const auto before = found(m.name + u8"/exit"); before && *before != m.exitStatus)
+				{
+					std::cout << boost::format(u8"  exit status changed from %1%.") % *before << std::endl;
+				}
+
+				regressions += regressed ? 1 : 0;
+				results.results.insert(std::end(results.results), std::begin(programResults), std::end(programResults));
+			}
+		}
+
+		meteor::benchmark::save(options, results);
+
+		if (regressions > 0)
+		{
+			std::cout << boost::format(u8"%1% program(s) regressed.") % regressions << std::endl;
+
+			return 1;
+		}
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+
+		return 1;
+	}
+}
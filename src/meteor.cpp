@@ -23,66 +23,568 @@
 ================================================================================*/
 
 #include "meteor/cc/Compiler.hpp"
+#include "meteor/cc/Lexer.hpp"
 #include "meteor/cc/Printer.hpp"
 #include "meteor/cc/Parser.hpp"
 #include "meteor/cc/SymbolAnalyzer.hpp"
 
+#include "meteor/runtime/CallGraphProfiler.hpp"
+#include "meteor/runtime/Coverage.hpp"
+#include "meteor/runtime/CycleModel.hpp"
+#include "meteor/runtime/ExecutionTrace.hpp"
+#include "meteor/runtime/LineProfile.hpp"
+#include "meteor/runtime/OpcodeStatistics.hpp"
 #include "meteor/runtime/Processor.hpp"
+#include "meteor/runtime/Profiler.hpp"
+#include "meteor/runtime/SamplingProfiler.hpp"
+#include "meteor/runtime/StackProfiler.hpp"
+#include "meteor/runtime/TraceObserver.hpp"
+#include "meteor/runtime/UndoLog.hpp"
+#include "meteor/AllocationHooks.hpp"
+#include "meteor/Allocations.hpp"
+#include "meteor/TimeReport.hpp"
+#include "meteor/Tracer.hpp"
 
+#include <fstream>
 #include <iostream>
 
-int main()
+#include <boost/algorithm/string/predicate.hpp>
+
+namespace
 {
-	try
+	constexpr char defaultSource[] = u8R"(
+		int f(void) {
+			return 42;
+		}
+
+		int main(void) {
+			int *p;
+			int a;
+			int b;
+
+			a = 10;
+			p = &a;
+			*p = 42;
+			b = *p;
+
+			return b;
+
+			int (*g)(void);
+			g = &f;
+			return (*g)();
+		}
+	)";
+
+	struct Options
+	{
+		std::string sourcePath;
+		std::string recordPath;
+		std::string replayPath;
+		std::uint64_t budget = 1000;
+		std::string flameGraphPath;
+		std::string opcodeStatisticsPath;
+		std::string tracePath;
+		std::string executionTracePath;
+		std::string cycleCostsPath;
+		std::string timeReportPath;
+		std::uint64_t stepBack = 0;
+		std::uint64_t sampleInterval = 0;
+		bool profile = false;
+		bool callGraph = false;
+		bool coverage = false;
+		bool cycles = false;
+		bool stackProfile = false;
+		bool timeReport = false;
+		bool allocationReport = false;
+	};
+
+	[[nodiscard]]
+	Options parseOptions(int argc, char* argv[])
 	{
-		constexpr char source[] = u8R"(
-			int f(void) {
-				return 42;
+		Options options;
+
+		for (int i = 1; i < argc; i++)
+		{
+			const std::string_view arg = argv[i];
+
+			if (arg == u8"--record" && i + 1 < argc)
+			{
+				options.recordPath = argv[++i];
+			}
+			else if (arg == u8"--replay" && i + 1 < argc)
+			{
+				options.replayPath = argv[++i];
+			}
+			else if (arg == u8"--budget" && i + 1 < argc)
+			{
+				options.budget = std::stoull(argv[++i]);
+			}
+			else if (arg == u8"--profile")
+			{
+				options.profile = true;
+			}
+			else if (arg == u8"--call-graph")
+			{
+				options.callGraph = true;
+			}
+			else if (arg == u8"--flamegraph" && i + 1 < argc)
+			{
+				options.flameGraphPath = argv[++i];
+			}
+			else if (arg == u8"--opcode-stats" && i + 1 < argc)
+			{
+				options.opcodeStatisticsPath = argv[++i];
+			}
+			else if (arg == u8"--trace" && i + 1 < argc)
+			{
+				options.tracePath = argv[++i];
+			}
+			else if (arg == u8"--execution-trace" && i + 1 < argc)
+			{
+				options.executionTracePath = argv[++i];
+			}
+			else if (arg == u8"--step-back" && i + 1 < argc)
+			{
+				options.stepBack = std::stoull(argv[++i]);
+			}
+			else if (arg == u8"--coverage")
+			{
+				options.coverage = true;
+			}
+			else if (arg == u8"--cycles")
+			{
+				options.cycles = true;
 			}
+			else if (arg == u8"--cycle-costs" && i + 1 < argc)
+			{
+				options.cycles = true;
+				options.cycleCostsPath = argv[++i];
+			}
+			else if (arg == u8"--sample" && i + 1 < argc)
+			{
+				options.sampleInterval = std::stoull(argv[++i]);
+			}
+			else if (arg == u8"--stack-profile")
+			{
+				options.stackProfile = true;
+			}
+			else if (arg == u8"--time-report")
+			{
+				options.timeReport = true;
+			}
+			else if (arg == u8"--time-report-json" && i + 1 < argc)
+			{
+				options.timeReport = true;
+				options.timeReportPath = argv[++i];
+			}
+			else if (arg == u8"--alloc-report")
+			{
+				options.allocationReport = true;
+			}
+			else if (!arg.empty() && arg[0] != u8'-' && options.sourcePath.empty())
+			{
+				options.sourcePath = arg;
+			}
+			else
+			{
+				throw std::runtime_error { (boost::format(u8"unknown option `%1%'.") % arg).str() };
+			}
+		}
 
-			int main(void) {
-				int *p;
-				int a;
-				int b;
+		// --flamegraph is written by the sampling profiler if sampling, by the call-graph profiler otherwise.
+		if (!options.flameGraphPath.empty() && options.sampleInterval == 0)
+		{
+			options.callGraph = true;
+		}
 
-				a = 10;
-				p = &a;
-				*p = 42;
-				b = *p;
+		// Every run mode attaches its own observer to the processor, so at most one can be given.
+		const std::pair<const char*, bool> modes[] =
+		{
+			{ u8"--profile", options.profile },
+			{ u8"--sample", options.sampleInterval > 0 },
+			{ u8"--call-graph", options.callGraph },
+			{ u8"--opcode-stats", !options.opcodeStatisticsPath.empty() },
+			{ u8"--execution-trace", !options.executionTracePath.empty() },
+			{ u8"--cycles", options.cycles },
+			{ u8"--stack-profile", options.stackProfile },
+			{ u8"--coverage", options.coverage },
+			{ u8"--step-back", options.stepBack > 0 },
+			{ u8"--trace", !options.tracePath.empty() },
+		};
 
-				return b;
+		const char* mode = nullptr;
 
-				int (*g)(void);
-				g = &f;
-				return (*g)();
+		for (const auto& [name, active] : modes)
+		{
+			if (active && mode)
+			{
+				throw std::runtime_error { (boost::format(u8"options `%1%' and `%2%' cannot be combined.") % mode % name).str() };
 			}
-		)";
+			else if (active)
+			{
+				mode = name;
+			}
+		}
+
+		return options;
+	}
+
+	[[nodiscard]]
+	std::string readSource(const Options& options)
+	{
+		if (options.sourcePath.empty())
+		{
+			return defaultSource;
+		}
+
+		std::ifstream stream { options.sourcePath };
+
+		if (!stream)
+		{
+			throw std::runtime_error { (boost::format(u8"cannot open `%1%'.") % options.sourcePath).str() };
+		}
+
+		return std::string { std::istreambuf_iterator<char> { stream }, std::istreambuf_iterator<char> {} };
+	}
+
+	// Opens `path' for writing, or throws.
+	[[nodiscard]]
+	std::ofstream create(const std::string& path, std::ios::openmode mode = std::ios::out)
+	{
+		std::ofstream stream { path, mode };
+
+		if (!stream)
+		{
+			throw std::runtime_error { (boost::format(u8"cannot open `%1%'.") % path).str() };
+		}
+
+		return stream;
+	}
+
+	// Closes a stream opened by create(), and throws if anything written to it was lost.
+	void close(std::ofstream& stream, const std::string& path)
+	{
+		stream.close();
+
+		if (!stream)
+		{
+			throw std::runtime_error { (boost::format(u8"cannot write `%1%'.") % path).str() };
+		}
+	}
+
+	// `run' runs the processor for the budget, by default with Processor::run.
+	template <typename Processor, typename Run>
+	void execute(Processor& processor, const Options& options, meteor::Tracer* tracer, Run run)
+	{
+		auto recordLog = std::make_shared<meteor::runtime::SystemCallLog>();
+
+		if (!options.recordPath.empty())
+		{
+			processor.record(recordLog);
+		}
+
+		if (!options.replayPath.empty())
+		{
+			std::ifstream stream { options.replayPath, std::ios::binary };
+
+			if (!stream)
+			{
+				throw std::runtime_error { (boost::format(u8"cannot open `%1%'.") % options.replayPath).str() };
+			}
+
+			processor.replay(std::make_shared<meteor::runtime::SystemCallLog>(meteor::runtime::SystemCallLog::load(stream)));
+		}
+
+		{
+			meteor::Tracer::Scope scope { tracer, u8"run" };
+
+			run(processor, options.budget);
+		}
+
+		std::cout << "steps: " << processor.steps() << std::endl;
+
+		if (!options.recordPath.empty())
+		{
+			std::ofstream stream { options.recordPath, std::ios::binary };
+
+			if (!stream)
+			{
+				throw std::runtime_error { (boost::format(u8"cannot open `%1%'.") % options.recordPath).str() };
+			}
+
+			recordLog->save(stream);
+		}
+	}
+
+	template <typename Processor>
+	void execute(Processor& processor, const Options& options, meteor::Tracer* tracer)
+	{
+		execute(processor, options, tracer, [](Processor& p, std::uint64_t budget) { p.run(budget); });
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	try
+	{
+		const auto options = parseOptions(argc, argv);
+		const auto source = readSource(options);
+		const auto filename = options.sourcePath.empty() ? std::string { u8"test.c" } : options.sourcePath;
+
+		auto tracer = options.tracePath.empty() ? nullptr : std::make_unique<meteor::Tracer>();
+		auto timeReport = options.timeReport ? std::make_unique<meteor::TimeReport>() : nullptr;
+		auto allocationTracker = options.allocationReport
+			? std::make_unique<meteor::allocations::Tracker>(std::count(std::begin(source), std::end(source), u8'\n') + 1)
+			: nullptr;
+
+		if (allocationTracker)
+		{
+			allocationTracker->start();
+		}
 
-		auto parser = meteor::cc::Parser { "test.c", source };
-		auto ast = parser.parse();
+		auto parser = meteor::cc::Parser { filename, source };
 		auto compiler = meteor::cc::Compiler {};
 
-		meteor::cc::SymbolAnalyzer {}.resolve(*ast);
+		if (timeReport)
+		{
+			// The parser lexes on demand, so lexing is also timed as a pass of its own.
+			meteor::TimeReport::Scope scope { timeReport.get(), u8"lex" };
+			auto lexer = meteor::cc::Lexer { filename, source };
+
+			while (lexer.read()->kind() != meteor::cc::TokenKind::endOfFile)
+			{
+			}
+		}
+
+		auto ast = [&]
+		{
+			meteor::Tracer::Scope scope { tracer.get(), u8"parse" };
+			meteor::TimeReport::Scope phase { timeReport.get(), u8"parse" };
+
+			return parser.parse();
+		}();
+
+		{
+			meteor::Tracer::Scope scope { tracer.get(), u8"resolve" };
+			meteor::TimeReport::Scope phase { timeReport.get(), u8"resolve" };
+
+			meteor::cc::SymbolAnalyzer {}.resolve(*ast);
+		}
+
+		auto program = [&]
+		{
+			meteor::Tracer::Scope scope { tracer.get(), u8"compile" };
+			meteor::TimeReport::Scope phase { timeReport.get(), u8"compile" };
+
+			return compiler.compile(*ast);
+		}();
+
+		{
+			meteor::TimeReport::Scope phase { timeReport.get(), u8"print" };
+
+			meteor::cc::Printer {std::cout}.print(*ast);
+		}
+
+		if (allocationTracker)
+		{
+			allocationTracker->stop();
+
+			if (!meteor::TimeReport::enabled)
+			{
+				std::cerr << u8"allocation report: built without METEOR_TIME_REPORT; configure with -DMETEOR_TIME_REPORT=ON" << std::endl;
+			}
+
+			allocationTracker->report(std::cerr, source);
+		}
+
+		if (timeReport)
+		{
+			if (!meteor::TimeReport::enabled)
+			{
+				std::cerr << u8"time report: built without METEOR_TIME_REPORT; configure with -DMETEOR_TIME_REPORT=ON" << std::endl;
+			}
 
-		auto program = compiler.compile(*ast);
+			timeReport->print(std::cerr);
 
-		meteor::cc::Printer {std::cout}.print(*ast);
+			if (!options.timeReportPath.empty())
+			{
+				auto stream = create(options.timeReportPath);
+
+				timeReport->writeJSON(stream);
+				close(stream, options.timeReportPath);
+			}
+		}
 
 		for (meteor::Word addr = 0; addr < program.size(); addr++)
 		{
 			std::cout << boost::format(u8"%1$04X: %2$04X") % addr % program[addr] << std::endl;
 		}
 
-		auto memory = std::make_shared<meteor::runtime::Memory>(program);
-		auto processor = meteor::runtime::Processor(memory);
+		auto memory = [&]
+		{
+			meteor::Tracer::Scope scope { tracer.get(), u8"load" };
 
-		std::size_t steps = 0;
+			return std::make_shared<meteor::runtime::Memory>(program);
+		}();
 
-		while (steps++ < 1000 && processor.step())
+		if (options.profile)
 		{
+			auto profiler = meteor::runtime::Profiler {};
+			auto processor = meteor::runtime::BasicProcessor { memory, profiler };
+
+			execute(processor, options, tracer.get());
+
+			profiler.report(std::cout, *memory);
+
+			std::cout << std::endl;
+
+			meteor::runtime::LineProfile { profiler, compiler.lineTable(), program.size() }.report(std::cout, source);
+		}
+		else if (options.sampleInterval > 0)
+		{
+			auto profiler = meteor::runtime::SamplingProfiler { options.sampleInterval };
+			auto processor = meteor::runtime::Processor { memory };
+
+			execute(processor, options, tracer.get(), [&](meteor::runtime::Processor& p, std::uint64_t budget) { profiler.run(p, budget); });
+
+			profiler.report(std::cout, compiler.symbolMap());
+
+			if (!options.flameGraphPath.empty())
+			{
+				auto stream = create(options.flameGraphPath);
+
+				profiler.writeCollapsedStacks(stream, compiler.symbolMap(), *memory);
+				close(stream, options.flameGraphPath);
+			}
+		}
+		else if (options.callGraph)
+		{
+			auto profiler = meteor::runtime::CallGraphProfiler { compiler.symbolMap() };
+			auto processor = meteor::runtime::BasicProcessor { memory, profiler };
+
+			execute(processor, options, tracer.get());
+
+			profiler.report(std::cout);
+
+			if (!options.flameGraphPath.empty())
+			{
+				auto stream = create(options.flameGraphPath);
+
+				profiler.writeCollapsedStacks(stream);
+				close(stream, options.flameGraphPath);
+			}
+		}
+		else if (!options.opcodeStatisticsPath.empty())
+		{
+			auto statistics = meteor::runtime::OpcodeStatistics {};
+			auto processor = meteor::runtime::BasicProcessor { memory, statistics };
+
+			execute(processor, options, tracer.get());
+
+			auto stream = create(options.opcodeStatisticsPath);
+
+			if (boost::algorithm::ends_with(options.opcodeStatisticsPath, u8".json"))
+			{
+				statistics.writeJSON(stream);
+			}
+			else
+			{
+				statistics.writeCSV(stream);
+			}
+
+			close(stream, options.opcodeStatisticsPath);
+		}
+		else if (!options.executionTracePath.empty())
+		{
+			auto stream = create(options.executionTracePath, std::ios::binary);
+
+			auto recorder = meteor::runtime::ExecutionTraceRecorder { stream };
+			auto processor = meteor::runtime::BasicProcessor { memory, recorder };
+
+			execute(processor, options, tracer.get());
+
+			recorder.finish();
+			close(stream, options.executionTracePath);
+		}
+		else if (options.cycles)
+		{
+			auto costs = meteor::runtime::CycleCosts {};
+
+			if (!options.cycleCostsPath.empty())
+			{
+				std::ifstream stream { options.cycleCostsPath };
+
+				if (!stream)
+				{
+					throw std::runtime_error { (boost::format(u8"cannot open `%1%'.") % options.cycleCostsPath).str() };
+				}
+
+				costs = meteor::runtime::CycleCosts::load(stream);
+			}
+
+			auto counter = meteor::runtime::CycleCounter { costs };
+			auto processor = meteor::runtime::BasicProcessor { memory, counter };
+
+			execute(processor, options, tracer.get());
+
+			std::cout << "cycles: " << counter.cycles() << std::endl;
+
+			counter.report(std::cout, compiler.symbolMap());
+		}
+		else if (options.stackProfile)
+		{
+			auto profiler = meteor::runtime::StackProfiler { compiler.symbolMap() };
+			auto processor = meteor::runtime::BasicProcessor { memory, profiler };
+
+			execute(processor, options, tracer.get());
+
+			profiler.report(std::cout);
+		}
+		else if (options.coverage)
+		{
+			auto coverage = meteor::runtime::EdgeCoverage {};
+			auto processor = meteor::runtime::BasicProcessor { memory, coverage };
+
+			execute(processor, options, tracer.get());
+
+			coverage.classify();
+
+			std::cout << "edges: " << coverage.edges() << std::endl;
+		}
+		else if (options.stepBack > 0)
+		{
+			auto undoLog = meteor::runtime::UndoLog {};
+			auto processor = meteor::runtime::BasicProcessor { memory, undoLog };
+
+			execute(processor, options, tracer.get());
+
+			const auto undone = processor.stepBack(options.stepBack);
+
+			std::cout << "stepped back: " << undone << ", steps: " << processor.steps() << std::endl;
+
+			processor.dumpRegisters(std::cout);
+		}
+		else if (tracer)
+		{
+			auto observer = meteor::runtime::TraceObserver { *tracer, compiler.symbolMap() };
+			auto processor = meteor::runtime::BasicProcessor { memory, observer };
+
+			execute(processor, options, tracer.get());
+
+			observer.finish();
+
+			auto stream = create(options.tracePath);
+
+			tracer->write(stream);
+			close(stream, options.tracePath);
+		}
+		else
+		{
+			auto processor = meteor::runtime::Processor(memory);
+
+			execute(processor, options, tracer.get());
 		}
 
-		std::cout << "steps: " << steps << std::endl;
 		memory->dump(std::cout, 0x0000, 0x0040);
 		// processor.dumpRegisters(std::cout);
 	}
@@ -92,10 +594,14 @@ int main()
 			<< "*** caught exception ***" << std::endl
 			<< "type: " << typeid(e).name() << std::endl
 			<< "what: " << e.what() << std::endl;
+
+		return 1;
 	}
 	catch (...)
 	{
 		std::cerr
 			<< "*** caught unknown exception ***" << std::endl;
+
+		return 1;
 	}
 }
@@ -0,0 +1,140 @@
+/*================================================================================
+ * The MIT License
+ *
+ * Copyright (c) 2018 Ryooooooga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+================================================================================*/
+
+// Replaces the global operator new/delete to feed meteor::allocations.
+// Defines non-inline functions: include from exactly one translation unit.
+
+#pragma once
+
+#include "Allocations.hpp"
+
+#ifdef METEOR_TIME_REPORT
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace meteor::allocations::detail
+{
+	// The block size is kept in a header that preserves fundamental alignment.
+	constexpr std::size_t headerSize = alignof(std::max_align_t);
+
+	inline void* allocate(std::size_t size) noexcept
+	{
+		auto block = static_cast<unsigned char*>(std::malloc(size + headerSize));
+
+		if (!block)
+		{
+			return nullptr;
+		}
+
+		*reinterpret_cast<std::size_t*>(block) = size;
+		allocated(size);
+
+		return block + headerSize;
+	}
+
+	inline void deallocate(void* pointer) noexcept
+	{
+		if (pointer)
+		{
+			auto block = static_cast<unsigned char*>(pointer) - headerSize;
+
+			deallocated(*reinterpret_cast<std::size_t*>(block));
+			std::free(block);
+		}
+	}
+
+	inline void* allocateOrThrow(std::size_t size)
+	{
+		while (true)
+		{
+			if (auto pointer = allocate(size))
+			{
+				return pointer;
+			}
+
+			if (auto handler = std::get_new_handler())
+			{
+				handler();
+			}
+			else
+			{
+				throw std::bad_alloc {};
+			}
+		}
+	}
+}
+
+void* operator new(std::size_t size)
+{
+	return meteor::allocations::detail::allocateOrThrow(size);
+}
+
+void* operator new[](std::size_t size)
+{
+	return meteor::allocations::detail::allocateOrThrow(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	return meteor::allocations::detail::allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+	return meteor::allocations::detail::allocate(size);
+}
+
+void operator delete(void* pointer) noexcept
+{
+	meteor::allocations::detail::deallocate(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+	meteor::allocations::detail::deallocate(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+	meteor::allocations::detail::deallocate(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept
+{
+	meteor::allocations::detail::deallocate(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept
+{
+	meteor::allocations::detail::deallocate(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept
+{
+	meteor::allocations::detail::deallocate(pointer);
+}
+
+#endif
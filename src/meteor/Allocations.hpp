@@ -0,0 +1,318 @@
+/*================================================================================
+ * The MIT License
+ *
+ * Copyright (c) 2018 Ryooooooga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+================================================================================*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+#include <boost/format.hpp>
+
+namespace meteor::allocations
+{
+	// Updated by the replacement operator new/delete in AllocationHooks.hpp; zero without them.
+	struct Counters
+	{
+		std::atomic<std::uint64_t> count;
+		std::atomic<std::size_t> current;
+		std::atomic<std::size_t> peak;
+	};
+
+	inline Counters counters {};
+
+	// What the current thread is doing; names must be string literals.
+	struct Site
+	{
+		std::string_view phase;
+		std::string_view kind;
+		std::size_t line;
+	};
+
+	inline thread_local Site site {};
+
+#ifdef METEOR_TIME_REPORT
+	// Attributes the allocations in its lifetime to a kind and a source line, restoring the outer site on exit.
+	class Tag
+	{
+	public:
+		explicit Tag(std::string_view kind, std::size_t line) noexcept
+			: m_kind(site.kind)
+			, m_line(site.line)
+		{
+			site.kind = kind;
+			site.line = line;
+		}
+
+		// Uncopyable, unmovable.
+		Tag(const Tag&) =delete;
+		Tag(Tag&&) =delete;
+
+		Tag& operator=(const Tag&) =delete;
+		Tag& operator=(Tag&&) =delete;
+
+		~Tag()
+		{
+			site.kind = m_kind;
+			site.line = m_line;
+		}
+
+	private:
+		std::string_view m_kind;
+		std::size_t m_line;
+	};
+#else
+	class Tag
+	{
+	public:
+		explicit Tag(std::string_view, std::size_t) noexcept
+		{
+		}
+	};
+#endif
+
+	// Tallies the allocations of the thread that started it by phase, kind and source line.
+	// Recording never allocates; names beyond the fixed capacity are lumped together.
+	class Tracker
+	{
+	public:
+		struct Tally
+		{
+			std::uint64_t count;
+			std::uint64_t bytes;
+		};
+
+		explicit Tracker(std::size_t lines)
+			: m_phases()
+			, m_kinds()
+			, m_lines(lines + 1, Tally {})
+			, m_total()
+		{
+		}
+
+		// Uncopyable, unmovable.
+		Tracker(const Tracker&) =delete;
+		Tracker(Tracker&&) =delete;
+
+		Tracker& operator=(const Tracker&) =delete;
+		Tracker& operator=(Tracker&&) =delete;
+
+		~Tracker()
+		{
+			stop();
+		}
+
+		void start() noexcept
+		{
+			active() = this;
+		}
+
+		void stop() noexcept
+		{
+			if (active() == this)
+			{
+				active() = nullptr;
+			}
+		}
+
+		void record(std::size_t size) noexcept
+		{
+			const auto add = [size](Tally& tally) noexcept
+			{
+				tally.count++;
+				tally.bytes += size;
+			};
+
+			add(m_total);
+			add(m_phases.at(site.phase));
+			add(m_kinds.at(site.kind));
+			add(m_lines[std::min(site.line, m_lines.size() - 1)]);
+		}
+
+		[[nodiscard]]
+		static Tracker*& active() noexcept
+		{
+			thread_local Tracker* tracker = nullptr;
+
+			return tracker;
+		}
+
+		// Allocations by phase and kind, then the `top' lines with the most allocations.
+		void report(std::ostream& stream, std::string_view source, std::size_t top = 10) const
+		{
+			stream << boost::format(u8"allocations: %1% (%2% bytes)") % m_total.count % m_total.bytes << std::endl;
+
+			m_phases.print(stream, u8"phase");
+			m_kinds.print(stream, u8"kind");
+
+			std::vector<std::size_t> lines;
+
+			for (std::size_t line = 0; line < m_lines.size(); line++)
+			{
+				if (m_lines[line].count > 0)
+				{
+					lines.emplace_back(line);
+				}
+			}
+
+			std::sort(std::begin(lines), std::end(lines), [&](std::size_t a, std::size_t b)
+			{
+				return m_lines[a].count > m_lines[b].count;
+			});
+
+			lines.resize(std::min(lines.size(), top));
+
+			stream << std::endl << boost::format(u8"%1$6s %2$10s %3$10s  %4%") % u8"line" % u8"allocs" % u8"bytes" % u8"source" << std::endl;
+
+			for (const auto line : lines)
+			{
+				stream
+					<< boost::format(u8"%1$6s %2$10d %3$10d  %4%")
+						% (line == 0 ? std::string { u8"-" } : std::to_string(line))
+						% m_lines[line].count
+						% m_lines[line].bytes
+						% sourceLine(source, line)
+					<< std::endl;
+			}
+		}
+
+	private:
+		static constexpr std::size_t capacity = 64;
+
+		class Table
+		{
+		public:
+			Tally& at(std::string_view name) noexcept
+			{
+				for (std::size_t i = 0; i < m_size; i++)
+				{
+					if (m_names[i].data() == name.data() || m_names[i] == name)
+					{
+						return m_tallies[i];
+					}
+				}
+
+				if (m_size == capacity)
+				{
+					return m_tallies[capacity - 1];
+				}
+
+				m_names[m_size] = name;
+
+				return m_tallies[m_size++];
+			}
+
+			void print(std::ostream& stream, std::string_view title) const
+			{
+				std::vector<std::size_t> order(m_size);
+
+				for (std::size_t i = 0; i < m_size; i++)
+				{
+					order[i] = i;
+				}
+
+				std::sort(std::begin(order), std::end(order), [&](std::size_t a, std::size_t b)
+				{
+					return m_tallies[a].count > m_tallies[b].count;
+				});
+
+				stream << std::endl << boost::format(u8"%1$-28s %2$10s %3$10s") % title % u8"allocs" % u8"bytes" << std::endl;
+
+				for (const auto i : order)
+				{
+					stream
+						<< boost::format(u8"%1$-28s %2$10d %3$10d")
+							% (m_names[i].empty() ? std::string_view { u8"-" } : m_names[i])
+							% m_tallies[i].count
+							% m_tallies[i].bytes
+						<< std::endl;
+				}
+			}
+
+		private:
+			std::array<std::string_view, capacity> m_names {};
+			std::array<Tally, capacity> m_tallies {};
+			std::size_t m_size = 0;
+		};
+
+		[[nodiscard]]
+		static std::string_view sourceLine(std::string_view source, std::size_t line) noexcept
+		{
+			if (line == 0)
+			{
+				return {};
+			}
+
+			std::size_t begin = 0;
+
+			for (std::size_t i = 1; i < line && begin != std::string_view::npos; i++)
+			{
+				begin = source.find(u8'\n', begin);
+				begin = begin == std::string_view::npos ? begin : begin + 1;
+			}
+
+			if (begin == std::string_view::npos)
+			{
+				return {};
+			}
+
+			auto text = source.substr(begin, source.find(u8'\n', begin) - begin);
+
+			text.remove_prefix(std::min(text.find_first_not_of(u8" \t"), text.size()));
+
+			return text;
+		}
+
+		Table m_phases;
+		Table m_kinds;
+		std::vector<Tally> m_lines;
+		Tally m_total;
+	};
+
+	inline void allocated(std::size_t size) noexcept
+	{
+		counters.count.fetch_add(1, std::memory_order_relaxed);
+
+		const auto current = counters.current.fetch_add(size, std::memory_order_relaxed) + size;
+		auto peak = counters.peak.load(std::memory_order_relaxed);
+
+		while (peak < current && !counters.peak.compare_exchange_weak(peak, current, std::memory_order_relaxed))
+		{
+		}
+
+		if (const auto tracker = Tracker::active())
+		{
+			tracker->record(size);
+		}
+	}
+
+	inline void deallocated(std::size_t size) noexcept
+	{
+		counters.current.fetch_sub(size, std::memory_order_relaxed);
+	}
+}
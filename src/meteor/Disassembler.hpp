@@ -0,0 +1,125 @@
+/*================================================================================
+ * The MIT License
+ *
+ * Copyright (c) 2018 Ryooooooga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+================================================================================*/
+
+#pragma once
+
+#include <string>
+
+#include <boost/format.hpp>
+
+#include "Operation.hpp"
+
+namespace meteor::operations
+{
+	[[nodiscard]]
+	constexpr const char* mnemonic(Word code) noexcept
+	{
+		switch (operationCode(code))
+		{
+			case nop      : return "NOP";
+			case ld_adr   : return "LD";
+			case st       : return "ST";
+			case lad      : return "LAD";
+			case ld_r     : return "LD";
+			case adda_adr : return "ADDA";
+			case suba_adr : return "SUBA";
+			case addl_adr : return "ADDL";
+			case subl_adr : return "SUBL";
+			case adda_r   : return "ADDA";
+			case suba_r   : return "SUBA";
+			case addl_r   : return "ADDL";
+			case subl_r   : return "SUBL";
+			case and_adr  : return "AND";
+			case or_adr   : return "OR";
+			case xor_adr  : return "XOR";
+			case and_r    : return "AND";
+			case or_r     : return "OR";
+			case xor_r    : return "XOR";
+			case cpa_adr  : return "CPA";
+			case cpl_adr  : return "CPL";
+			case cpa_r    : return "CPA";
+			case cpl_r    : return "CPL";
+			case sla_adr  : return "SLA";
+			case sra_adr  : return "SRA";
+			case sll_adr  : return "SLL";
+			case srl_adr  : return "SRL";
+			case jmi      : return "JMI";
+			case jnz      : return "JNZ";
+			case jze      : return "JZE";
+			case jump     : return "JUMP";
+			case jpl      : return "JPL";
+			case jov      : return "JOV";
+			case push     : return "PUSH";
+			case pop      : return "POP";
+			case call     : return "CALL";
+			case ret      : return "RET";
+			case svc      : return "SVC";
+			default       : return nullptr;
+		}
+	}
+
+	// Formats an instruction as assembly, e.g. `LD GR1, #0003, GR7'.
+	// `operand' is the second word, ignored by one-word instructions.
+	[[nodiscard]]
+	inline std::string disassemble(Word code, Word operand)
+	{
+		const auto name = mnemonic(code);
+
+		if (name == nullptr)
+		{
+			return (boost::format(u8"DC #%1$04X") % code).str();
+		}
+
+		const auto [r1, r2] = registers(code);
+		const auto address = r2 == Register::general0
+			? (boost::format(u8"#%1$04X") % operand).str()
+			: (boost::format(u8"#%1$04X, %2%") % operand % r2).str();
+
+		switch (operationCode(code))
+		{
+			case nop:
+			case ret:
+				return name;
+
+			case pop:
+				return (boost::format(u8"%1% %2%") % name % r1).str();
+
+			case jmi:
+			case jnz:
+			case jze:
+			case jump:
+			case jpl:
+			case jov:
+			case push:
+			case call:
+			case svc:
+				return (boost::format(u8"%1% %2%") % name % address).str();
+
+			default:
+				return length(code) == 1
+					? (boost::format(u8"%1% %2%, %3%") % name % r1 % r2).str()
+					: (boost::format(u8"%1% %2%, %3%") % name % r1 % address).str();
+		}
+	}
+}
@@ -0,0 +1,110 @@
+/*================================================================================
+ * The MIT License
+ *
+ * Copyright (c) 2018 Ryooooooga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+================================================================================*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+#include <boost/format.hpp>
+
+#include "Type.hpp"
+
+namespace meteor
+{
+	// Run-length encoded map from program addresses to source lines.
+	class LineTable
+	{
+	public:
+		struct Run
+		{
+			Word start;
+			std::size_t line; // 0 for compiler-generated code
+		};
+
+		explicit LineTable() =default;
+
+		// Copyable, movable.
+		LineTable(const LineTable&) =default;
+		LineTable(LineTable&&) =default;
+
+		LineTable& operator=(const LineTable&) =default;
+		LineTable& operator=(LineTable&&) =default;
+
+		~LineTable() =default;
+
+		// Attributes the words from `address' onwards to `line'. Addresses must not decrease.
+		void mark(Word address, std::size_t line)
+		{
+			if (!m_runs.empty() && m_runs.back().line == line)
+			{
+				return;
+			}
+
+			if (!m_runs.empty() && m_runs.back().start == address)
+			{
+				m_runs.back().line = line;
+
+				if (m_runs.size() >= 2 && m_runs[m_runs.size() - 2].line == line)
+				{
+					m_runs.pop_back();
+				}
+
+				return;
+			}
+
+			m_runs.emplace_back(Run { address, line });
+		}
+
+		[[nodiscard]]
+		const std::vector<Run>& runs() const noexcept
+		{
+			return m_runs;
+		}
+
+		[[nodiscard]]
+		std::size_t line(Word address) const noexcept
+		{
+			auto it = std::upper_bound(std::begin(m_runs), std::end(m_runs), address, [](Word address, const Run& run)
+			{
+				return address < run.start;
+			});
+
+			return it == std::begin(m_runs) ? 0 : (--it)->line;
+		}
+
+		void print(std::ostream& stream) const
+		{
+			for (const auto& run : m_runs)
+			{
+				stream << boost::format(u8"%1$04X %2%") % run.start % run.line << std::endl;
+			}
+		}
+
+	private:
+		std::vector<Run> m_runs;
+	};
+}
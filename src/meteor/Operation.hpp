@@ -91,6 +91,60 @@ namespace meteor
 			return code & 0xff00;
 		}
 
+		// Number of words of the instruction, including its address operand.
+		[[nodiscard]]
+		constexpr Word length(Word code) noexcept
+		{
+			switch (operationCode(code))
+			{
+				case nop:
+				case ld_r:
+				case adda_r:
+				case suba_r:
+				case addl_r:
+				case subl_r:
+				case and_r:
+				case or_r:
+				case xor_r:
+				case cpa_r:
+				case cpl_r:
+				case pop:
+				case ret:
+					return 1;
+
+				default:
+					return 2;
+			}
+		}
+
+		// Number of data memory accesses of the instruction, excluding the instruction fetch.
+		[[nodiscard]]
+		constexpr Word memoryAccesses(Word code) noexcept
+		{
+			switch (operationCode(code))
+			{
+				case ld_adr:
+				case st:
+				case adda_adr:
+				case suba_adr:
+				case addl_adr:
+				case subl_adr:
+				case and_adr:
+				case or_adr:
+				case xor_adr:
+				case cpa_adr:
+				case cpl_adr:
+				case push:
+				case pop:
+				case call:
+				case ret:
+					return 1;
+
+				default:
+					return 0;
+			}
+		}
+
 		[[nodiscard]]
 		constexpr std::pair<Register, Register> registers(Word code) noexcept
 		{
@@ -0,0 +1,106 @@
+/*================================================================================
+ * The MIT License
+ *
+ * Copyright (c) 2018 Ryooooooga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+================================================================================*/
+
+#pragma once
+
+#include <algorithm>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <boost/format.hpp>
+
+#include "Type.hpp"
+
+namespace meteor
+{
+	// Address ranges of the functions in a program image.
+	class SymbolMap
+	{
+	public:
+		struct Function
+		{
+			std::string name;
+			Word start;
+			Word end; // exclusive
+		};
+
+		explicit SymbolMap() =default;
+
+		// Copyable, movable.
+		SymbolMap(const SymbolMap&) =default;
+		SymbolMap(SymbolMap&&) =default;
+
+		SymbolMap& operator=(const SymbolMap&) =default;
+		SymbolMap& operator=(SymbolMap&&) =default;
+
+		~SymbolMap() =default;
+
+		void add(std::string name, Word start, Word end)
+		{
+			const auto it = std::upper_bound(std::begin(m_functions), std::end(m_functions), start, [](Word address, const Function& f)
+			{
+				return address < f.start;
+			});
+
+			m_functions.insert(it, Function { std::move(name), start, end });
+		}
+
+		[[nodiscard]]
+		const std::vector<Function>& functions() const noexcept
+		{
+			return m_functions;
+		}
+
+		// Index of the function containing the address, or `npos'.
+		[[nodiscard]]
+		std::size_t find(Word address) const noexcept
+		{
+			auto it = std::upper_bound(std::begin(m_functions), std::end(m_functions), address, [](Word address, const Function& f)
+			{
+				return address < f.start;
+			});
+
+			if (it == std::begin(m_functions) || address >= (--it)->end)
+			{
+				return npos;
+			}
+
+			return static_cast<std::size_t>(it - std::begin(m_functions));
+		}
+
+		void print(std::ostream& stream) const
+		{
+			for (const auto& f : m_functions)
+			{
+				stream << boost::format(u8"%1$04X %2$04X %3%") % f.start % f.end % f.name << std::endl;
+			}
+		}
+
+		constexpr static std::size_t npos = static_cast<std::size_t>(-1);
+
+	private:
+		std::vector<Function> m_functions;
+	};
+}
@@ -30,8 +30,22 @@ namespace meteor
 {
 	namespace system_calls
 	{
-		constexpr Word exit  = 0x0001; // GR0: exit status.
-		constexpr Word read  = 0x0002; // GR0: reserved, GR1: buffer, GR2: size
-		constexpr Word write = 0x0003; // GR0: reserved, GR1: buffer, GR2: size
+		constexpr Word exit  = 0x0001; // GR1: exit status.
+		constexpr Word read  = 0x0002; // GR1: buffer, GR2: size -> GR1: number of characters read
+		constexpr Word write = 0x0003; // GR1: buffer, GR2: size -> GR1: number of characters written
+
+		constexpr Word returnFromInterrupt = 0x0010; // Pops FR and PC pushed by an interrupt.
+
+		constexpr Word fetchAdd       = 0x0020; // GR1: address, GR2: addend -> GR1: previous value
+		constexpr Word compareAndSwap = 0x0021; // GR1: address, GR2: expected, GR3: desired -> GR1: previous value
+		constexpr Word processorId    = 0x0022; // -> GR1: index of the processor
+
+		constexpr Word send    = 0x0030; // GR1: port, GR2: value (parks while the channel is full)
+		constexpr Word receive = 0x0031; // GR1: port -> GR1: value (parks while the channel is empty)
+
+		// Counters since the last resetCounters, or since the processor started, modulo 2^32.
+		constexpr Word readInstructions = 0x0040; // -> GR1:GR2: retired instructions (high:low), including this SVC
+		constexpr Word readCycles       = 0x0041; // -> GR1:GR2: cycles of the cycle model (high:low), including this SVC
+		constexpr Word resetCounters    = 0x0042; // Restarts both counters from 0.
 	}
 }
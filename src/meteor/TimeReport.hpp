@@ -0,0 +1,179 @@
+/*================================================================================
+ * The MIT License
+ *
+ * Copyright (c) 2018 Ryooooooga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+================================================================================*/
+
+#pragma once
+
+#include "Allocations.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <boost/format.hpp>
+
+namespace meteor
+{
+	// Wall time, allocation count and peak live heap bytes per compiler phase, in the style of -ftime-report.
+	// Scopes compile to nothing unless METEOR_TIME_REPORT is defined.
+	class TimeReport
+	{
+	public:
+		struct Phase
+		{
+			std::string_view name;
+			double seconds;
+			std::uint64_t allocations;
+			std::size_t peakBytes;
+		};
+
+#ifdef METEOR_TIME_REPORT
+		static constexpr bool enabled = true;
+
+		// Records the scope as a phase, which also names the phase of its allocations; scopes must not nest.
+		class Scope
+		{
+		public:
+			explicit Scope(TimeReport* report, std::string_view name) noexcept
+				: m_report(report)
+				, m_name(name)
+				, m_allocations(allocations::counters.count.load(std::memory_order_relaxed))
+				, m_base(allocations::counters.current.load(std::memory_order_relaxed))
+				, m_start(std::chrono::steady_clock::now())
+			{
+				// Restart the high-water mark so that it covers this phase alone.
+				allocations::counters.peak.store(m_base, std::memory_order_relaxed);
+
+				m_phase = std::exchange(allocations::site.phase, name);
+			}
+
+			// Uncopyable, unmovable.
+			Scope(const Scope&) =delete;
+			Scope(Scope&&) =delete;
+
+			Scope& operator=(const Scope&) =delete;
+			Scope& operator=(Scope&&) =delete;
+
+			~Scope()
+			{
+				allocations::site.phase = m_phase;
+
+				if (m_report)
+				{
+					const auto peak = allocations::counters.peak.load(std::memory_order_relaxed);
+
+					m_report->m_phases.emplace_back(Phase {
+						m_name,
+						std::chrono::duration<double> { std::chrono::steady_clock::now() - m_start }.count(),
+						allocations::counters.count.load(std::memory_order_relaxed) - m_allocations,
+						peak > m_base ? peak - m_base : 0,
+					});
+				}
+			}
+
+		private:
+			TimeReport* m_report;
+			std::string_view m_name;
+			std::uint64_t m_allocations;
+			std::size_t m_base;
+			std::chrono::steady_clock::time_point m_start;
+			std::string_view m_phase;
+		};
+#else
+		static constexpr bool enabled = false;
+
+		class Scope
+		{
+		public:
+			explicit Scope(TimeReport*, std::string_view) noexcept
+			{
+			}
+		};
+#endif
+
+		[[nodiscard]]
+		const std::vector<Phase>& phases() const noexcept
+		{
+			return m_phases;
+		}
+
+		void print(std::ostream& stream) const
+		{
+			double total = 0.0;
+			std::uint64_t allocations = 0;
+			std::size_t peakBytes = 0;
+
+			for (const auto& phase : m_phases)
+			{
+				total += phase.seconds;
+				allocations += phase.allocations;
+				peakBytes = std::max(peakBytes, phase.peakBytes);
+			}
+
+			stream << std::endl << u8"Execution times (seconds)" << std::endl;
+
+			for (const auto& phase : m_phases)
+			{
+				stream
+					<< boost::format(u8" %1$-12s: %2$9.6f (%3$3.0f%%) %4$10d allocs %5$10d kB")
+						% phase.name
+						% phase.seconds
+						% (total > 0.0 ? phase.seconds / total * 100.0 : 0.0)
+						% phase.allocations
+						% ((phase.peakBytes + 1023) / 1024)
+					<< std::endl;
+			}
+
+			stream
+				<< boost::format(u8" %1$-12s: %2$9.6f        %3$10d allocs %4$10d kB") % u8"TOTAL" % total % allocations % ((peakBytes + 1023) / 1024)
+				<< std::endl;
+		}
+
+		void writeJSON(std::ostream& stream) const
+		{
+			stream << u8"{\"phases\":[";
+
+			for (std::size_t i = 0; i < m_phases.size(); i++)
+			{
+				const auto& phase = m_phases[i];
+
+				stream
+					<< (i > 0 ? u8"," : u8"") << std::endl
+					<< boost::format(u8"{\"name\":\"%1%\",\"seconds\":%2$.9f,\"allocations\":%3%,\"peak_bytes\":%4%}")
+						% phase.name
+						% phase.seconds
+						% phase.allocations
+						% phase.peakBytes;
+			}
+
+			stream << std::endl << u8"]}" << std::endl;
+		}
+
+	private:
+		std::vector<Phase> m_phases;
+	};
+}
@@ -0,0 +1,195 @@
+/*================================================================================
+ * The MIT License
+ *
+ * Copyright (c) 2018 Ryooooooga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+================================================================================*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+#include <boost/format.hpp>
+
+namespace meteor
+{
+	// Collects complete events into per-thread buffers and writes them as Chrome trace_event JSON.
+	// Recording takes no lock once a thread has its buffer; names must outlive write().
+	class Tracer
+	{
+	public:
+		// Host events are timed in nanoseconds since construction, guest events in processor steps.
+		enum class Clock : std::uint32_t
+		{
+			host = 1,
+			guest = 2,
+		};
+
+		struct Event
+		{
+			std::string_view name;
+			std::string_view category;
+			std::uint64_t start;
+			std::uint64_t duration;
+			Clock clock;
+		};
+
+		// Records the lifetime of the scope as a host event; does nothing without a tracer.
+		class Scope
+		{
+		public:
+			explicit Scope(Tracer* tracer, std::string_view name, std::string_view category = u8"host")
+				: m_tracer(tracer)
+				, m_name(name)
+				, m_category(category)
+				, m_start(tracer ? tracer->now() : 0)
+			{
+			}
+
+			// Uncopyable, unmovable.
+			Scope(const Scope&) =delete;
+			Scope(Scope&&) =delete;
+
+			Scope& operator=(const Scope&) =delete;
+			Scope& operator=(Scope&&) =delete;
+
+			~Scope()
+			{
+				if (m_tracer)
+				{
+					m_tracer->add(Event { m_name, m_category, m_start, m_tracer->now() - m_start, Clock::host });
+				}
+			}
+
+		private:
+			Tracer* m_tracer;
+			std::string_view m_name;
+			std::string_view m_category;
+			std::uint64_t m_start;
+		};
+
+		explicit Tracer()
+			: m_id(nextId())
+			, m_epoch(std::chrono::steady_clock::now())
+			, m_mutex()
+			, m_buffers()
+		{
+		}
+
+		// Uncopyable, unmovable.
+		Tracer(const Tracer&) =delete;
+		Tracer(Tracer&&) =delete;
+
+		Tracer& operator=(const Tracer&) =delete;
+		Tracer& operator=(Tracer&&) =delete;
+
+		~Tracer() =default;
+
+		[[nodiscard]]
+		std::uint64_t now() const noexcept
+		{
+			return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_epoch).count());
+		}
+
+		void add(const Event& event)
+		{
+			buffer().events.emplace_back(event);
+		}
+
+		// Serializes every buffer; call once the recording threads are done.
+		void write(std::ostream& stream) const
+		{
+			std::lock_guard<std::mutex> lock { m_mutex };
+
+			stream << u8"{\"traceEvents\":[" << std::endl;
+			stream << u8"{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"host (us)\"}}," << std::endl;
+			stream << u8"{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":2,\"tid\":0,\"args\":{\"name\":\"guest (steps)\"}}";
+
+			for (const auto& buffer : m_buffers)
+			{
+				for (const auto& event : buffer->events)
+				{
+					// Guest steps are shown as microseconds.
+					const double scale = event.clock == Clock::host ? 1000.0 : 1.0;
+
+					stream
+						<< u8"," << std::endl
+						<< boost::format(u8"{\"name\":\"%1%\",\"cat\":\"%2%\",\"ph\":\"X\",\"ts\":%3$.3f,\"dur\":%4$.3f,\"pid\":%5%,\"tid\":%6%}")
+							% event.name
+							% event.category
+							% (event.start / scale)
+							% (event.duration / scale)
+							% static_cast<std::uint32_t>(event.clock)
+							% buffer->thread;
+				}
+			}
+
+			stream << std::endl << u8"],\"displayTimeUnit\":\"ns\"}" << std::endl;
+		}
+
+	private:
+		struct Buffer
+		{
+			std::size_t thread;
+			std::vector<Event> events;
+		};
+
+		Buffer& buffer()
+		{
+			thread_local std::uint64_t owner = 0;
+			thread_local Buffer* cached = nullptr;
+
+			if (owner != m_id)
+			{
+				std::lock_guard<std::mutex> lock { m_mutex };
+
+				m_buffers.emplace_back(std::make_unique<Buffer>(Buffer { m_buffers.size() + 1, {} }));
+				m_buffers.back()->events.reserve(4096);
+
+				owner = m_id;
+				cached = m_buffers.back().get();
+			}
+
+			return *cached;
+		}
+
+		// Identifies the tracer to the thread-local buffer cache, unlike an address that may be reused.
+		[[nodiscard]]
+		static std::uint64_t nextId() noexcept
+		{
+			static std::atomic<std::uint64_t> id { 0 };
+
+			return ++id;
+		}
+
+		std::uint64_t m_id;
+		std::chrono::steady_clock::time_point m_epoch;
+		mutable std::mutex m_mutex;
+		std::deque<std::unique_ptr<Buffer>> m_buffers;
+	};
+}
@@ -24,7 +24,9 @@
 
 #pragma once
 
+#include "../LineTable.hpp"
 #include "../Operation.hpp"
+#include "../SymbolMap.hpp"
 #include "Node.hpp"
 #include "TypeInfo.hpp"
 
@@ -53,6 +55,35 @@ namespace meteor::cc
 			return m_program;
 		}
 
+		// Address ranges of the compiled functions, available after compile().
+		[[nodiscard]]
+		const SymbolMap& symbolMap() const noexcept
+		{
+			return m_symbolMap;
+		}
+
+		// Source lines of the compiled words, available after compile().
+		[[nodiscard]]
+		const LineTable& lineTable() const noexcept
+		{
+			return m_lineTable;
+		}
+
+		// Address following the startup code that sets GR0 and the frame pointer, available after compile().
+		// A processor whose registers are set up by its host may start there.
+		[[nodiscard]]
+		Word entryPoint() const noexcept
+		{
+			return m_entryPoint;
+		}
+
+		// Frame pointer set by the startup code, the end of the image; available after compile().
+		[[nodiscard]]
+		Word frameBase() const noexcept
+		{
+			return m_frameBase;
+		}
+
 	private:
 		constexpr static Register framePointer = Register::general7;
 
@@ -70,6 +101,8 @@ namespace meteor::cc
 			// Set frame pointer.
 			const auto fp = add_LAD(framePointer);
 
+			m_entryPoint = position();
+
 			// Call main.
 			// CALL ?
 			const auto mainAddress = add_CALL();
@@ -78,6 +111,8 @@ namespace meteor::cc
 			// SVC #0001
 			add_SVC(0x0001);
 
+			m_symbolMap.add(u8"_start", 0x0000, position());
+
 			// Compile functions.
 			// external-declaration*
 			m_isLocal = false;
@@ -85,7 +120,7 @@ namespace meteor::cc
 
 			for (const auto& child : node.children())
 			{
-				child->accept(*this);
+				generate(*child);
 			}
 
 			if (m_main == nullptr)
@@ -93,7 +128,8 @@ namespace meteor::cc
 				throw std::runtime_error(std::string {node.filename()} + u8": function `main' is not defined.");
 			}
 
-			m_program[fp] = position();
+			m_frameBase = position();
+			m_program[fp] = m_frameBase;
 			m_program[mainAddress] = m_main->address();
 		}
 
@@ -105,7 +141,7 @@ namespace meteor::cc
 			// parameter-declaration*
 			for (const auto& child : node.children())
 			{
-				child->accept(*this);
+				generate(*child);
 			}
 		}
 
@@ -118,7 +154,7 @@ namespace meteor::cc
 			for (const auto& child : node.children())
 			{
 				// assignment-expression
-				child->accept(*this);
+				generate(*child);
 
 				// ST GR1, n, FP
 				add_ST(Register::general1, m_locals, framePointer);
@@ -143,7 +179,7 @@ namespace meteor::cc
 			// statement*
 			for (const auto& child : node.children())
 			{
-				child->accept(*this);
+				generate(*child);
 			}
 
 			// Restore the local address.
@@ -157,7 +193,7 @@ namespace meteor::cc
 		{
 			// condition
 			m_lvalue = false;
-			node.condition().accept(*this);
+			generate(node.condition());
 
 			// CPA GR1, #0000
 			add_CPA(Register::general1, 0x0000);
@@ -168,7 +204,7 @@ namespace meteor::cc
 				const auto elseLabel = add_JZE();
 
 				// then
-				node.then().accept(*this);
+				generate(node.then());
 
 				// JUMP .endif
 				const auto endIfLabel = add_JUMP();
@@ -177,7 +213,7 @@ namespace meteor::cc
 				m_program[elseLabel] = position();
 
 				// else
-				otherwise->accept(*this);
+				generate(*otherwise);
 
 				// .endif
 				m_program[endIfLabel] = position();
@@ -188,7 +224,7 @@ namespace meteor::cc
 				const auto endIfLabel = add_JZE();
 
 				// then
-				node.then().accept(*this);
+				generate(node.then());
 
 				// .endif
 				m_program[endIfLabel] = position();
@@ -204,7 +240,7 @@ namespace meteor::cc
 
 			// condition
 			m_lvalue = false;
-			node.condition().accept(*this);
+			generate(node.condition());
 
 			// CPA GR1, #0000
 			add_CPA(Register::general1, 0x0000);
@@ -213,7 +249,7 @@ namespace meteor::cc
 			const Word endWhileLabel = add_JZE();
 
 			// body
-			node.body().accept(*this);
+			generate(node.body());
 
 			// JUMP .startwhile
 			add_JUMP(startPos);
@@ -229,7 +265,7 @@ namespace meteor::cc
 			// expression
 			if (const auto expression = node.expression())
 			{
-				expression->accept(*this);
+				generate(*expression);
 			}
 
 			// RET
@@ -242,15 +278,17 @@ namespace meteor::cc
 		{
 			// expression
 			m_lvalue = false;
-			node.expression().accept(*this);
+			generate(node.expression());
 		}
 
 		// function-declaration:
 		//     type declarator compound-statement
 		void visit(FunctionDeclarationNode& node)
 		{
+			const Word start = position();
+
 			// Save the function address.
-			node.symbol()->address({}, true, position());
+			node.symbol()->address({}, true, start);
 
 			if (node.symbol()->name() == u8"main")
 			{
@@ -262,13 +300,15 @@ namespace meteor::cc
 			m_parameters = true;
 			m_locals = 0x0000;
 
-			node.declarator().accept(*this);
+			generate(node.declarator());
 
 			// compound-statement
-			node.body().accept(*this);
+			generate(node.body());
 
 			// RET
 			add_RET();
+
+			m_symbolMap.add(std::string {node.symbol()->name()}, start, position());
 		}
 
 		// variable-declaration:
@@ -315,7 +355,7 @@ namespace meteor::cc
 		void visit(PointerDeclaratorNode& node)
 		{
 			// direct-declarator
-			node.declarator().accept(*this);
+			generate(node.declarator());
 		}
 
 		// function-declarator:
@@ -323,12 +363,12 @@ namespace meteor::cc
 		void visit(FunctionDeclaratorNode& node)
 		{
 			// direct-declarator
-			node.declarator().accept(*this);
+			generate(node.declarator());
 
 			if (m_parameters)
 			{
 				// parameter-list
-				node.parameters().accept(*this);
+				generate(node.parameters());
 
 				m_parameters = false;
 			}
@@ -339,14 +379,14 @@ namespace meteor::cc
 		void visit(AssignmentExpressionNode& node)
 		{
 			// right-hand-side
-			node.right().accept(*this);
+			generate(node.right());
 
 			// PUSH #0000, GR1
 			add_PUSH(0x0000, Register::general1);
 
 			// left-hand-side
 			const auto lvalueSaved = std::exchange(m_lvalue, true);
-			node.left().accept(*this);
+			generate(node.left());
 			m_lvalue = lvalueSaved;
 
 			// POP GR2
@@ -360,13 +400,13 @@ namespace meteor::cc
 		void visit(AdditionExpressionNode& node)
 		{
 			// right-hand-side
-			node.right().accept(*this);
+			generate(node.right());
 
 			// PUSH #0000, GR1
 			add_PUSH(0x0000, Register::general1);
 
 			// left-hand-side
-			node.left().accept(*this);
+			generate(node.left());
 
 			// POP GR2
 			add_POP(Register::general2);
@@ -379,13 +419,13 @@ namespace meteor::cc
 		void visit(SubtractionExpressionNode& node)
 		{
 			// right-hand-side
-			node.right().accept(*this);
+			generate(node.right());
 
 			// PUSH #0000, GR1
 			add_PUSH(0x0000, Register::general1);
 
 			// left-hand-side
-			node.left().accept(*this);
+			generate(node.left());
 
 			// POP GR2
 			add_POP(Register::general2);
@@ -398,7 +438,7 @@ namespace meteor::cc
 		void visit(PlusExpressionNode& node)
 		{
 			// operand
-			node.operand().accept(*this);
+			generate(node.operand());
 		}
 
 		// minus-expression:
@@ -406,7 +446,7 @@ namespace meteor::cc
 		void visit(MinusExpressionNode& node)
 		{
 			// operand
-			node.operand().accept(*this);
+			generate(node.operand());
 
 			// LD GR2, GR1
 			add_LD(Register::general2, Register::general1);
@@ -422,7 +462,7 @@ namespace meteor::cc
 		{
 			// operand
 			const auto lvalueSaved = std::exchange(m_lvalue, true);
-			node.operand().accept(*this);
+			generate(node.operand());
 			m_lvalue = lvalueSaved;
 		}
 
@@ -432,7 +472,7 @@ namespace meteor::cc
 		{
 			// operand
 			const auto lvalueSaved = std::exchange(m_lvalue, false);
-			node.operand().accept(*this);
+			generate(node.operand());
 			m_lvalue = lvalueSaved;
 
 			if (!m_lvalue)
@@ -449,11 +489,11 @@ namespace meteor::cc
 			// argument-list
 			const auto lvalueSaved = std::exchange(m_lvalue, false);
 			const auto localsSaved = m_locals;
-			node.arguments().accept(*this);
+			generate(node.arguments());
 
 			// callee
 			m_lvalue = true;
-			node.callee().accept(*this);
+			generate(node.callee());
 
 			m_lvalue = lvalueSaved;
 			m_locals = localsSaved;
@@ -518,6 +558,16 @@ namespace meteor::cc
 		{
 		}
 
+		// Compiles the node, attributing its words to its source line.
+		void generate(Node& node)
+		{
+			const auto line = m_line;
+
+			m_line = node.line();
+			node.accept(*this);
+			m_line = line;
+		}
+
 		[[nodiscard]]
 		Word position() const noexcept
 		{
@@ -526,8 +576,12 @@ namespace meteor::cc
 
 		void addWord(Word word)
 		{
-			assert(m_program.size() <= 0xffff);
+			if (m_program.size() > 0xffff)
+			{
+				throw std::runtime_error(u8"the program exceeds the 65536-word address space.");
+			}
 
+			m_lineTable.mark(position(), m_line);
 			m_program.emplace_back(word);
 		}
 
@@ -675,6 +729,11 @@ namespace meteor::cc
 		}
 
 		std::vector<Word> m_program;
+		SymbolMap m_symbolMap;
+		LineTable m_lineTable;
+		Word m_entryPoint = 0;
+		Word m_frameBase = 0;
+		std::size_t m_line = 0;
 		bool m_isLocal;
 		bool m_parameters;
 		bool m_lvalue;
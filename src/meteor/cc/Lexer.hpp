@@ -65,31 +65,37 @@ namespace meteor::cc
 			return m_code;
 		}
 
+		[[nodiscard]]
+		std::size_t line() const noexcept
+		{
+			return m_line;
+		}
+
 		[[nodiscard]]
 		std::unique_ptr<Token> read()
 		{
 			while (!eof())
 			{
 				// \s
-				constexpr auto isWhitespace = [](char c) noexcept
+				static constexpr auto isWhitespace = [](char c) noexcept
 				{
 					return c == u8'\t' || c == u8'\r' || c == u8'\n' || c == u8'\v' || c == u8'\f' || c == u8' ';
 				};
 
 				// [0-9]
-				constexpr auto isDigit = [](char c) noexcept
+				static constexpr auto isDigit = [](char c) noexcept
 				{
 					return u8'0' <= c && c <= u8'9';
 				};
 
 				// [A-Z_a-z]
-				constexpr auto isIdentifierStart = [](char c) noexcept
+				static constexpr auto isIdentifierStart = [](char c) noexcept
 				{
 					return (u8'A' <= c && c <= u8'Z') || (u8'a' <= c && c <= u8'z') || (c == u8'_');
 				};
 
 				// [0-9A-Z_a-z]
-				constexpr auto isIdentifierContinuation = [](char c) noexcept
+				static constexpr auto isIdentifierContinuation = [](char c) noexcept
 				{
 					return isIdentifierStart(c) || isDigit(c);
 				};
@@ -26,8 +26,10 @@
 
 #include <cassert>
 #include <memory>
+#include <string_view>
 #include <vector>
 
+#include "../Allocations.hpp"
 #include "Symbol.hpp"
 
 namespace meteor::cc
@@ -36,6 +38,13 @@ namespace meteor::cc
 	class Parser;
 
 #define METEOR_CC_NODE(name) class name;
+#include "Node.def.hpp"
+
+	// Class name of a node type, for diagnostics.
+	template <typename T>
+	inline constexpr std::string_view nodeName {};
+
+#define METEOR_CC_NODE(name) template <> inline constexpr std::string_view nodeName<name> { #name };
 #include "Node.def.hpp"
 
 	class IVisitor
@@ -43,6 +52,15 @@ namespace meteor::cc
 	public:
 		virtual ~IVisitor() =default;
 
+		// Visits the node, attributing the allocations of the visit to its kind and line.
+		template <typename T>
+		void dispatch(T& node)
+		{
+			const allocations::Tag tag { nodeName<T>, node.line() };
+
+			visit(node);
+		}
+
 #define METEOR_CC_NODE(name) virtual void visit(name& node) =0;
 #include "Node.def.hpp"
 	};
@@ -190,7 +208,7 @@ namespace meteor::cc
 
 		void accept(IVisitor& visitor) override
 		{
-			visitor.visit(*this);
+			visitor.dispatch(*this);
 		}
 
 		void scope(Passkey<SymbolAnalyzer>, const std::shared_ptr<Scope>& scope)
@@ -217,7 +235,7 @@ namespace meteor::cc
 
 		void accept(IVisitor& visitor) override
 		{
-			visitor.visit(*this);
+			visitor.dispatch(*this);
 		}
 	};
 
@@ -242,7 +260,7 @@ namespace meteor::cc
 
 		void accept(IVisitor& visitor) override
 		{
-			visitor.visit(*this);
+			visitor.dispatch(*this);
 		}
 
 		void scope(Passkey<SymbolAnalyzer>, const std::shared_ptr<Scope>& scope)
@@ -293,7 +311,7 @@ namespace meteor::cc
 
 		void accept(IVisitor& visitor) override
 		{
-			visitor.visit(*this);
+			visitor.dispatch(*this);
 		}
 	};
 
@@ -327,7 +345,7 @@ namespace meteor::cc
 
 		void accept(IVisitor& visitor) override
 		{
-			visitor.visit(*this);
+			visitor.dispatch(*this);
 		}
 	};
 
@@ -351,7 +369,7 @@ namespace meteor::cc
 
 		void accept(IVisitor& visitor) override
 		{
-			visitor.visit(*this);
+			visitor.dispatch(*this);
 		}
 	};
 
@@ -377,7 +395,7 @@ namespace meteor::cc
 
 		void accept(IVisitor& visitor) override
 		{
-			visitor.visit(*this);
+			visitor.dispatch(*this);
 		}
 	};
 
@@ -428,7 +446,7 @@ namespace meteor::cc
 
 		void accept(IVisitor& visitor) override
 		{
-			visitor.visit(*this);
+			visitor.dispatch(*this);
 		}
 
 		void scope(Passkey<SymbolAnalyzer>, const std::shared_ptr<Scope>& scope)
@@ -478,7 +496,7 @@ namespace meteor::cc
 
 		void accept(IVisitor& visitor) override
 		{
-			visitor.visit(*this);
+			visitor.dispatch(*this);
 		}
 	};
 
@@ -518,7 +536,7 @@ namespace meteor::cc
 
 		void accept(IVisitor& visitor) override
 		{
-			visitor.visit(*this);
+			visitor.dispatch(*this);
 		}
 	};
 
@@ -551,7 +569,7 @@ namespace meteor::cc
 
 		void accept(IVisitor& visitor) override
 		{
-			visitor.visit(*this);
+			visitor.dispatch(*this);
 		}
 
 		void symbol(Passkey<SymbolAnalyzer>, const std::shared_ptr<Symbol>& symbol)
@@ -594,7 +612,7 @@ namespace meteor::cc
 
 		void accept(IVisitor& visitor) override
 		{
-			visitor.visit(*this);
+			visitor.dispatch(*this);
 		}
 	};
 
@@ -616,7 +634,7 @@ namespace meteor::cc
 
 		void accept(IVisitor& visitor) override
 		{
-			visitor.visit(*this);
+			visitor.dispatch(*this);
 		}
 	};
 
@@ -656,7 +674,7 @@ namespace meteor::cc
 
 		void accept(IVisitor& visitor) override
 		{
-			visitor.visit(*this);
+			visitor.dispatch(*this);
 		}
 	};
 
@@ -718,7 +736,7 @@ namespace meteor::cc
 
 		void accept(IVisitor& visitor) override
 		{
-			visitor.visit(*this);
+			visitor.dispatch(*this);
 		}
 	};
 
@@ -732,7 +750,7 @@ namespace meteor::cc
 
 		void accept(IVisitor& visitor) override
 		{
-			visitor.visit(*this);
+			visitor.dispatch(*this);
 		}
 	};
 
@@ -746,7 +764,7 @@ namespace meteor::cc
 
 		void accept(IVisitor& visitor) override
 		{
-			visitor.visit(*this);
+			visitor.dispatch(*this);
 		}
 	};
 
@@ -760,7 +778,7 @@ namespace meteor::cc
 
 		void accept(IVisitor& visitor) override
 		{
-			visitor.visit(*this);
+			visitor.dispatch(*this);
 		}
 	};
 
@@ -774,7 +792,7 @@ namespace meteor::cc
 
 		void accept(IVisitor& visitor) override
 		{
-			visitor.visit(*this);
+			visitor.dispatch(*this);
 		}
 	};
 
@@ -788,7 +806,7 @@ namespace meteor::cc
 
 		void accept(IVisitor& visitor) override
 		{
-			visitor.visit(*this);
+			visitor.dispatch(*this);
 		}
 	};
 
@@ -802,7 +820,7 @@ namespace meteor::cc
 
 		void accept(IVisitor& visitor) override
 		{
-			visitor.visit(*this);
+			visitor.dispatch(*this);
 		}
 	};
 
@@ -824,7 +842,7 @@ namespace meteor::cc
 
 		void accept(IVisitor& visitor) override
 		{
-			visitor.visit(*this);
+			visitor.dispatch(*this);
 		}
 	};
 
@@ -858,7 +876,7 @@ namespace meteor::cc
 
 		void accept(IVisitor& visitor) override
 		{
-			visitor.visit(*this);
+			visitor.dispatch(*this);
 		}
 	};
 
@@ -888,7 +906,7 @@ namespace meteor::cc
 
 		void accept(IVisitor& visitor) override
 		{
-			visitor.visit(*this);
+			visitor.dispatch(*this);
 		}
 
 		void symbol(Passkey<SymbolAnalyzer>, const std::shared_ptr<Symbol>& symbol)
@@ -923,7 +941,7 @@ namespace meteor::cc
 
 		void accept(IVisitor& visitor) override
 		{
-			visitor.visit(*this);
+			visitor.dispatch(*this);
 		}
 
 	private:
@@ -948,7 +966,7 @@ namespace meteor::cc
 
 		void accept(IVisitor& visitor) override
 		{
-			visitor.visit(*this);
+			visitor.dispatch(*this);
 		}
 
 		void typeInfo(Passkey<SymbolAnalyzer>, const std::shared_ptr<ITypeInfo>& typeInfo)
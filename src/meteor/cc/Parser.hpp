@@ -59,7 +59,7 @@ namespace meteor::cc
 		[[nodiscard]]
 		std::unique_ptr<RootNode> parseRoot()
 		{
-			auto node = std::make_unique<RootNode>(m_stream.name());
+			auto node = makeNode<RootNode>(m_stream.name());
 
 			// declaration*
 			while (peekToken()->kind() != TokenKind::endOfFile)
@@ -122,7 +122,7 @@ namespace meteor::cc
 			// ';'
 			const auto token = matchToken(TokenKind::semicolon);
 
-			return std::make_unique<EmptyStatementNode>(token->line());
+			return makeNode<EmptyStatementNode>(token->line());
 		}
 
 		// compound-statement:
@@ -133,7 +133,7 @@ namespace meteor::cc
 			// '{'
 			const auto token = matchToken(TokenKind::leftBrace);
 
-			auto node = std::make_unique<CompoundStatementNode>(token->line());
+			auto node = makeNode<CompoundStatementNode>(token->line());
 
 			// statement*
 			while (peekToken()->kind() != TokenKind::rightBrace)
@@ -166,13 +166,13 @@ namespace meteor::cc
 			// 'else'?
 			if (!consumeTokenIf(TokenKind::keyword_else))
 			{
-				return std::make_unique<IfStatementNode>(token->line(), std::move(condition), std::move(then), nullptr);
+				return makeNode<IfStatementNode>(token->line(), std::move(condition), std::move(then), nullptr);
 			}
 
 			// compound-statement
 			auto otherwise = parseCompoundStatement();
 
-			return std::make_unique<IfStatementNode>(token->line(), std::move(condition), std::move(then), std::move(otherwise));
+			return makeNode<IfStatementNode>(token->line(), std::move(condition), std::move(then), std::move(otherwise));
 		}
 
 		// while-statement:
@@ -189,7 +189,7 @@ namespace meteor::cc
 			// compound-statement
 			auto body = parseCompoundStatement();
 
-			return std::make_unique<WhileStatementNode>(token->line(), std::move(condition), std::move(body));
+			return makeNode<WhileStatementNode>(token->line(), std::move(condition), std::move(body));
 		}
 
 		// return-statement:
@@ -203,7 +203,7 @@ namespace meteor::cc
 			// ';'?
 			if (consumeTokenIf(TokenKind::semicolon))
 			{
-				return std::make_unique<ReturnStatementNode>(token->line(), nullptr);
+				return makeNode<ReturnStatementNode>(token->line(), nullptr);
 			}
 
 			// expression
@@ -212,7 +212,7 @@ namespace meteor::cc
 			// ';'
 			matchToken(TokenKind::semicolon);
 
-			return std::make_unique<ReturnStatementNode>(token->line(), std::move(expression));
+			return makeNode<ReturnStatementNode>(token->line(), std::move(expression));
 		}
 
 		// expression-statement:
@@ -226,7 +226,7 @@ namespace meteor::cc
 			// ';'
 			matchToken(TokenKind::semicolon);
 
-			return std::make_unique<ExpressionStatementNode>(expression->line(), std::move(expression));
+			return makeNode<ExpressionStatementNode>(expression->line(), std::move(expression));
 		}
 
 		// --- declaration ---
@@ -272,7 +272,7 @@ namespace meteor::cc
 			// compound-statement
 			auto body = parseCompoundStatement();
 
-			return std::make_unique<FunctionDeclarationNode>(declarator->line(), std::move(typeSpecifier), std::move(declarator), std::move(body));
+			return makeNode<FunctionDeclarationNode>(declarator->line(), std::move(typeSpecifier), std::move(declarator), std::move(body));
 		}
 
 		// variable-declaration:
@@ -283,7 +283,7 @@ namespace meteor::cc
 			// ';'
 			matchToken(TokenKind::semicolon);
 
-			return std::make_unique<VariableDeclarationNode>(declarator->line(), std::move(typeSpecifier), std::move(declarator));
+			return makeNode<VariableDeclarationNode>(declarator->line(), std::move(typeSpecifier), std::move(declarator));
 		}
 
 		// parameter-declaration:
@@ -297,7 +297,7 @@ namespace meteor::cc
 			// declarator
 			auto declarator = parseDeclarator();
 
-			return std::make_unique<ParameterDeclarationNode>(declarator->line(), std::move(typeSpecifier), std::move(declarator));
+			return makeNode<ParameterDeclarationNode>(declarator->line(), std::move(typeSpecifier), std::move(declarator));
 		}
 
 		// --- declarator ---
@@ -365,7 +365,7 @@ namespace meteor::cc
 			// parameter-list
 			auto parameters = parseParameterList();
 
-			return std::make_unique<FunctionDeclaratorNode>(declarator->line(), std::move(declarator), std::move(parameters));
+			return makeNode<FunctionDeclaratorNode>(declarator->line(), std::move(declarator), std::move(parameters));
 		}
 
 		// parameter-list:
@@ -377,7 +377,7 @@ namespace meteor::cc
 			// '('
 			const auto token = matchToken(TokenKind::leftParen);
 
-			auto node = std::make_unique<ParameterListNode>(token->line());
+			auto node = makeNode<ParameterListNode>(token->line());
 
 			// 'void'?
 			if (!consumeTokenIf(TokenKind::keyword_void))
@@ -423,7 +423,7 @@ namespace meteor::cc
 			// identifier
 			const auto token = matchToken(TokenKind::identifier);
 
-			return std::make_unique<IdentifierDeclaratorNode>(token->line(), token->text());
+			return makeNode<IdentifierDeclaratorNode>(token->line(), token->text());
 		}
 
 		// pointer-declarator:
@@ -437,7 +437,7 @@ namespace meteor::cc
 			// direct-declarator
 			auto declarator = parseDirectDeclarator();
 
-			return std::make_unique<PointerDeclaratorNode>(token->line(), std::move(declarator));
+			return makeNode<PointerDeclaratorNode>(token->line(), std::move(declarator));
 		}
 
 		// --- expression ---
@@ -497,7 +497,7 @@ namespace meteor::cc
 			// assignment-expression
 			auto right = parseAssignmentExpression();
 
-			return std::make_unique<AssignmentExpressionNode>(token->line(), std::move(left), std::move(right));
+			return makeNode<AssignmentExpressionNode>(token->line(), std::move(left), std::move(right));
 		}
 
 		// conditional-expression:
@@ -665,7 +665,7 @@ namespace meteor::cc
 			// multiplicative-expression
 			auto right = parseMultiplicativeExpression();
 
-			return std::make_unique<AdditionExpressionNode>(token->line(), std::move(left), std::move(right));
+			return makeNode<AdditionExpressionNode>(token->line(), std::move(left), std::move(right));
 		}
 
 		// '-' mutiplicative-expression
@@ -678,7 +678,7 @@ namespace meteor::cc
 			// multiplicative-expression
 			auto right = parseMultiplicativeExpression();
 
-			return std::make_unique<SubtractionExpressionNode>(token->line(), std::move(left), std::move(right));
+			return makeNode<SubtractionExpressionNode>(token->line(), std::move(left), std::move(right));
 		}
 
 		// multiplicative-expression:
@@ -750,7 +750,7 @@ namespace meteor::cc
 			// unary-expression
 			auto operand = parseUnaryExpression();
 
-			return std::make_unique<PlusExpressionNode>(token->line(), std::move(operand));
+			return makeNode<PlusExpressionNode>(token->line(), std::move(operand));
 		}
 
 		// minus-expression:
@@ -764,7 +764,7 @@ namespace meteor::cc
 			// unary-expression
 			auto operand = parseUnaryExpression();
 
-			return std::make_unique<MinusExpressionNode>(token->line(), std::move(operand));
+			return makeNode<MinusExpressionNode>(token->line(), std::move(operand));
 		}
 
 		// address-expression:
@@ -778,7 +778,7 @@ namespace meteor::cc
 			// unary-expression
 			auto operand = parseUnaryExpression();
 
-			return std::make_unique<AddressExpressionNode>(token->line(), std::move(operand));
+			return makeNode<AddressExpressionNode>(token->line(), std::move(operand));
 		}
 
 		// dereference-expression:
@@ -792,7 +792,7 @@ namespace meteor::cc
 			// unary-expression
 			auto operand = parseUnaryExpression();
 
-			return std::make_unique<DereferenceExpressionNode>(token->line(), std::move(operand));
+			return makeNode<DereferenceExpressionNode>(token->line(), std::move(operand));
 		}
 
 		// postfix-expression:
@@ -830,7 +830,7 @@ namespace meteor::cc
 			// '('
 			const auto token = matchToken(TokenKind::leftParen);
 
-			auto arguments = std::make_unique<ArgumentListNode>(token->line());
+			auto arguments = makeNode<ArgumentListNode>(token->line());
 
 			if (peekToken()->kind() != TokenKind::rightParen)
 			{
@@ -848,7 +848,7 @@ namespace meteor::cc
 			// ')'
 			matchToken(TokenKind::rightParen);
 
-			return std::make_unique<CallExpressionNode>(callee->line(), std::move(callee), std::move(arguments));
+			return makeNode<CallExpressionNode>(callee->line(), std::move(callee), std::move(arguments));
 		}
 
 		// primary-expression:
@@ -903,7 +903,7 @@ namespace meteor::cc
 			// identifier
 			const auto token = matchToken(TokenKind::identifier);
 
-			return std::make_unique<IdentifierExpressionNode>(token->line(), token->text());
+			return makeNode<IdentifierExpressionNode>(token->line(), token->text());
 		}
 
 		// integer-expression:
@@ -914,7 +914,7 @@ namespace meteor::cc
 			// integer-literal
 			const auto token = matchToken(TokenKind::integerLiteral);
 
-			return std::make_unique<IntegerExpressionNode>(token->line(), token->integer());
+			return makeNode<IntegerExpressionNode>(token->line(), token->integer());
 		}
 
 		// --- type ---
@@ -944,7 +944,17 @@ namespace meteor::cc
 			// 'int'
 			const auto token = matchToken(TokenKind::keyword_int);
 
-			return std::make_unique<IntegerTypeNode>(token->line());
+			return makeNode<IntegerTypeNode>(token->line());
+		}
+
+		// Allocates a node, attributing its allocations to its kind.
+		template <typename T, typename... Args>
+		[[nodiscard]]
+		std::unique_ptr<T> makeNode(Args&&... args)
+		{
+			const allocations::Tag tag { nodeName<T>, m_stream.line() };
+
+			return std::make_unique<T>(std::forward<Args>(args)...);
 		}
 
 		[[nodiscard]]
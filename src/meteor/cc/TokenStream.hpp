@@ -26,6 +26,7 @@
 
 #include <deque>
 
+#include "../Allocations.hpp"
 #include "Lexer.hpp"
 
 namespace meteor::cc
@@ -36,6 +37,7 @@ namespace meteor::cc
 		explicit TokenStream(Lexer&& lexer)
 			: m_lexer(std::move(lexer))
 			, m_queue()
+			, m_line(0)
 		{
 		}
 
@@ -60,10 +62,19 @@ namespace meteor::cc
 			return m_lexer.code();
 		}
 
+		// Line of the last consumed token.
+		[[nodiscard]]
+		std::size_t line() const noexcept
+		{
+			return m_line;
+		}
+
 		void fill(std::size_t size)
 		{
 			while (m_queue.size() < size)
 			{
+				const allocations::Tag tag { u8"Token", m_lexer.line() };
+
 				m_queue.emplace_back(m_lexer.read());
 			}
 		}
@@ -79,6 +90,7 @@ namespace meteor::cc
 		{
 			auto t = peek(0);
 			m_queue.pop_front();
+			m_line = t->line();
 
 			return t;
 		}
@@ -86,5 +98,6 @@ namespace meteor::cc
 	private:
 		Lexer m_lexer;
 		std::deque<std::shared_ptr<Token>> m_queue;
+		std::size_t m_line;
 	};
 }
@@ -0,0 +1,242 @@
+/*================================================================================
+ * The MIT License
+ *
+ * Copyright (c) 2018 Ryooooooga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+================================================================================*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <boost/format.hpp>
+
+#include "Observer.hpp"
+#include "../SymbolMap.hpp"
+
+namespace meteor::runtime
+{
+	// Attributes retired instructions to functions by tracking a shadow call stack on CALL and RET.
+	// Every distinct call stack is a node of a call tree, so each step costs one increment.
+	class CallGraphProfiler
+		: public NullObserver
+	{
+	public:
+		explicit CallGraphProfiler(SymbolMap symbolMap, Word entry = 0x0000)
+			: m_symbolMap(std::move(symbolMap))
+			, m_nodes()
+			, m_calls(m_symbolMap.functions().size() + 1, 0)
+			, m_current(0)
+		{
+			m_nodes.emplace_back(Node { function(entry), root, 0, {} });
+		}
+
+		// Uncopyable, movable.
+		CallGraphProfiler(const CallGraphProfiler&) =delete;
+		CallGraphProfiler(CallGraphProfiler&&) =default;
+
+		CallGraphProfiler& operator=(const CallGraphProfiler&) =delete;
+		CallGraphProfiler& operator=(CallGraphProfiler&&) =default;
+
+		~CallGraphProfiler() =default;
+
+		template <typename Processor>
+		void onStep([[maybe_unused]] const Processor& processor, [[maybe_unused]] Word pc, [[maybe_unused]] Word instruction) noexcept
+		{
+			m_nodes[m_current].steps++;
+		}
+
+		void onCall([[maybe_unused]] Word pc, Word target)
+		{
+			const auto callee = function(target);
+
+			m_calls[callee]++;
+			m_current = child(m_current, callee);
+		}
+
+		void onReturn([[maybe_unused]] Word pc, [[maybe_unused]] Word target) noexcept
+		{
+			if (m_nodes[m_current].parent != root)
+			{
+				m_current = m_nodes[m_current].parent;
+			}
+		}
+
+		struct FunctionProfile
+		{
+			std::string name;
+			std::uint64_t calls;
+			std::uint64_t inclusive;
+			std::uint64_t exclusive;
+		};
+
+		// Per-function profile, sorted by inclusive steps.
+		[[nodiscard]]
+		std::vector<FunctionProfile> functions() const
+		{
+			std::vector<FunctionProfile> profiles;
+
+			for (std::size_t f = 0; f < m_calls.size(); f++)
+			{
+				profiles.emplace_back(FunctionProfile { name(f), m_calls[f], 0, 0 });
+			}
+
+			// Subtree totals; children always come after their parent.
+			std::vector<std::uint64_t> totals(m_nodes.size());
+
+			for (auto i = m_nodes.size(); i-- > 0; )
+			{
+				totals[i] += m_nodes[i].steps;
+
+				if (m_nodes[i].parent != root)
+				{
+					totals[m_nodes[i].parent] += totals[i];
+				}
+			}
+
+			for (std::size_t i = 0; i < m_nodes.size(); i++)
+			{
+				auto& profile = profiles[m_nodes[i].function];
+
+				profile.exclusive += m_nodes[i].steps;
+
+				// Count recursive activations only once.
+				if (!hasAncestor(i, m_nodes[i].function))
+				{
+					profile.inclusive += totals[i];
+				}
+			}
+
+			profiles.erase(std::remove_if(std::begin(profiles), std::end(profiles), [](const auto& p)
+			{
+				return p.calls == 0 && p.inclusive == 0;
+			}), std::end(profiles));
+
+			std::stable_sort(std::begin(profiles), std::end(profiles), [](const auto& a, const auto& b)
+			{
+				return a.inclusive > b.inclusive;
+			});
+
+			return profiles;
+		}
+
+		void report(std::ostream& stream) const
+		{
+			stream << boost::format(u8"%1$-24s %2$12s %3$14s %4$14s") % u8"function" % u8"calls" % u8"inclusive" % u8"exclusive" << std::endl;
+
+			for (const auto& f : functions())
+			{
+				stream << boost::format(u8"%1$-24s %2$12d %3$14d %4$14d") % f.name % f.calls % f.inclusive % f.exclusive << std::endl;
+			}
+		}
+
+		// Writes `caller;callee steps' lines, the input format of flamegraph.pl.
+		void writeCollapsedStacks(std::ostream& stream) const
+		{
+			for (std::size_t i = 0; i < m_nodes.size(); i++)
+			{
+				if (m_nodes[i].steps == 0)
+				{
+					continue;
+				}
+
+				std::vector<std::size_t> stack;
+
+				for (auto n = i; n != root; n = m_nodes[n].parent)
+				{
+					stack.emplace_back(m_nodes[n].function);
+				}
+
+				for (auto it = std::rbegin(stack); it != std::rend(stack); ++it)
+				{
+					stream << (it == std::rbegin(stack) ? u8"" : u8";") << name(*it);
+				}
+
+				stream << u8" " << m_nodes[i].steps << std::endl;
+			}
+		}
+
+	private:
+		constexpr static std::size_t root = static_cast<std::size_t>(-1);
+
+		struct Node
+		{
+			std::size_t function;
+			std::size_t parent;
+			std::uint64_t steps;
+			std::vector<std::pair<std::size_t, std::size_t>> children; // (function, node)
+		};
+
+		// Index of the function containing the address; unknown addresses share the last index.
+		[[nodiscard]]
+		std::size_t function(Word address) const noexcept
+		{
+			const auto f = m_symbolMap.find(address);
+
+			return f == SymbolMap::npos ? m_symbolMap.functions().size() : f;
+		}
+
+		[[nodiscard]]
+		std::string name(std::size_t function) const
+		{
+			return function < m_symbolMap.functions().size() ? m_symbolMap.functions()[function].name : u8"[unknown]";
+		}
+
+		[[nodiscard]]
+		std::size_t child(std::size_t node, std::size_t function)
+		{
+			for (const auto& [f, n] : m_nodes[node].children)
+			{
+				if (f == function)
+				{
+					return n;
+				}
+			}
+
+			m_nodes.emplace_back(Node { function, node, 0, {} });
+			m_nodes[node].children.emplace_back(function, m_nodes.size() - 1);
+
+			return m_nodes.size() - 1;
+		}
+
+		[[nodiscard]]
+		bool hasAncestor(std::size_t node, std::size_t function) const noexcept
+		{
+			for (auto n = m_nodes[node].parent; n != root; n = m_nodes[n].parent)
+			{
+				if (m_nodes[n].function == function)
+				{
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		SymbolMap m_symbolMap;
+		std::vector<Node> m_nodes;
+		std::vector<std::uint64_t> m_calls;
+		std::size_t m_current;
+	};
+}
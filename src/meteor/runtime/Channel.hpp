@@ -0,0 +1,152 @@
+/*================================================================================
+ * The MIT License
+ *
+ * Copyright (c) 2018 Ryooooooga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+================================================================================*/
+
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+
+#include "../Type.hpp"
+
+namespace meteor::runtime
+{
+	// Bounded single-producer/single-consumer lock-free queue of words between two processors.
+	class Channel
+	{
+	public:
+		explicit Channel(std::size_t capacity)
+			: m_head(0)
+			, m_cachedTail(0)
+			, m_tail(0)
+			, m_cachedHead(0)
+			, m_mask(roundUp(capacity) - 1)
+			, m_buffer(std::make_unique<Word[]>(m_mask + 1))
+		{
+		}
+
+		// Uncopyable, unmovable.
+		Channel(const Channel&) =delete;
+		Channel(Channel&&) =delete;
+
+		Channel& operator=(const Channel&) =delete;
+		Channel& operator=(Channel&&) =delete;
+
+		~Channel() =default;
+
+		[[nodiscard]]
+		std::size_t capacity() const noexcept
+		{
+			return m_mask + 1;
+		}
+
+		// Producer side.
+		[[nodiscard]]
+		bool trySend(Word value) noexcept
+		{
+			const auto tail = m_tail.load(std::memory_order_relaxed);
+
+			if (tail - m_cachedHead == capacity())
+			{
+				m_cachedHead = m_head.load(std::memory_order_acquire);
+
+				if (tail - m_cachedHead == capacity())
+				{
+					return false;
+				}
+			}
+
+			m_buffer[tail & m_mask] = value;
+			m_tail.store(tail + 1, std::memory_order_release);
+
+			return true;
+		}
+
+		// Consumer side.
+		[[nodiscard]]
+		bool tryReceive(Word& value) noexcept
+		{
+			const auto head = m_head.load(std::memory_order_relaxed);
+
+			if (head == m_cachedTail)
+			{
+				m_cachedTail = m_tail.load(std::memory_order_acquire);
+
+				if (head == m_cachedTail)
+				{
+					return false;
+				}
+			}
+
+			value = m_buffer[head & m_mask];
+			m_head.store(head + 1, std::memory_order_release);
+
+			return true;
+		}
+
+		// Safe to call from any thread.
+		[[nodiscard]]
+		bool empty() const noexcept
+		{
+			return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+		}
+
+		// Safe to call from any thread.
+		[[nodiscard]]
+		bool full() const noexcept
+		{
+			return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire) >= capacity();
+		}
+
+	private:
+		constexpr static std::size_t cacheLineSize = 64;
+
+		[[nodiscard]]
+		static std::size_t roundUp(std::size_t capacity) noexcept
+		{
+			assert(capacity > 0);
+
+			std::size_t size = 1;
+
+			while (size < capacity)
+			{
+				size <<= 1;
+			}
+
+			return size;
+		}
+
+		// Consumer-owned.
+		alignas(cacheLineSize) std::atomic<std::size_t> m_head;
+		std::size_t m_cachedTail;
+
+		// Producer-owned.
+		alignas(cacheLineSize) std::atomic<std::size_t> m_tail;
+		std::size_t m_cachedHead;
+
+		alignas(cacheLineSize) const std::size_t m_mask;
+		const std::unique_ptr<Word[]> m_buffer;
+	};
+}
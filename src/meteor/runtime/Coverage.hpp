@@ -0,0 +1,214 @@
+/*================================================================================
+ * The MIT License
+ *
+ * Copyright (c) 2018 Ryooooooga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+================================================================================*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "Memory.hpp"
+#include "Observer.hpp"
+
+namespace meteor::runtime
+{
+	// AFL-style edge coverage: every taken jump, CALL and RET increments a byte of a 64 KiB map,
+	// indexed by a hash of its source and target addresses.
+	// Also remembers which pages the guest wrote, so memory can be restored between runs by copying only those.
+	class EdgeCoverage
+		: public NullObserver
+	{
+	public:
+		constexpr static std::size_t mapSize = 65536;
+
+		explicit EdgeCoverage()
+			: m_map(mapSize, 0)
+			, m_dirty()
+		{
+		}
+
+		// Uncopyable, movable.
+		EdgeCoverage(const EdgeCoverage&) =delete;
+		EdgeCoverage(EdgeCoverage&&) =default;
+
+		EdgeCoverage& operator=(const EdgeCoverage&) =delete;
+		EdgeCoverage& operator=(EdgeCoverage&&) =default;
+
+		~EdgeCoverage() =default;
+
+		void onBranch(Word pc, Word target, bool taken) noexcept
+		{
+			if (taken)
+			{
+				hit(pc, target);
+			}
+		}
+
+		void onCall(Word pc, Word target) noexcept
+		{
+			hit(pc, target);
+		}
+
+		void onReturn(Word pc, Word target) noexcept
+		{
+			hit(pc, target);
+		}
+
+		void onMemoryWrite(Word address, [[maybe_unused]] Word previous, [[maybe_unused]] Word value) noexcept
+		{
+			m_dirty[address >> pageBits] = true;
+		}
+
+		[[nodiscard]]
+		const std::vector<std::uint8_t>& map() const noexcept
+		{
+			return m_map;
+		}
+
+		// Replaces every hit count with its bucket bit: 1, 2, 3, 4-7, 8-15, 16-31, 32-127, 128+.
+		void classify() noexcept
+		{
+			for (auto& count : m_map)
+			{
+				count = buckets[count];
+			}
+		}
+
+		// Number of distinct edges hit.
+		[[nodiscard]]
+		std::size_t edges() const noexcept
+		{
+			return static_cast<std::size_t>(std::count_if(std::begin(m_map), std::end(m_map), [](auto count)
+			{
+				return count != 0;
+			}));
+		}
+
+		// Restores the pages written since the last call from the image, and clears the map for the next run.
+		void reset(Memory& memory, const std::vector<Word>& image) noexcept
+		{
+			for (std::size_t page = 0; page < pages; page++)
+			{
+				if (m_dirty[page])
+				{
+					memory.restore(image, page << pageBits, (page + 1) << pageBits);
+					m_dirty[page] = false;
+				}
+			}
+
+			std::fill(std::begin(m_map), std::end(m_map), 0);
+		}
+
+	private:
+		constexpr static std::size_t pageBits = 8;
+		constexpr static std::size_t pages = 65536 >> pageBits;
+
+		constexpr static std::array<std::uint8_t, 256> buckets = []
+		{
+			std::array<std::uint8_t, 256> table {};
+
+			for (std::size_t count = 1; count < table.size(); count++)
+			{
+				table[count] =
+					count <= 3   ? static_cast<std::uint8_t>(1 << (count - 1)) :
+					count <= 7   ? 8 :
+					count <= 15  ? 16 :
+					count <= 31  ? 32 :
+					count <= 127 ? 64 : 128;
+			}
+
+			return table;
+		}();
+
+		// Multiplying by an odd constant spreads nearby addresses over the map; shifting the source
+		// keeps A -> B and B -> A apart.
+		void hit(Word pc, Word target) noexcept
+		{
+			const auto index = static_cast<Word>((target * 40503u) ^ ((pc * 40503u) >> 1));
+
+			m_map[index] += m_map[index] != 0xff;
+		}
+
+		std::vector<std::uint8_t> m_map;
+		std::array<bool, pages> m_dirty;
+	};
+
+	// Bucket bits seen across all runs, to tell whether a run reached anything new.
+	class CoverageMap
+	{
+	public:
+		enum class Novelty
+		{
+			none,
+			hitCount,
+			edge,
+		};
+
+		explicit CoverageMap()
+			: m_seen(EdgeCoverage::mapSize, 0)
+		{
+		}
+
+		// Copyable, movable.
+		CoverageMap(const CoverageMap&) =default;
+		CoverageMap(CoverageMap&&) =default;
+
+		CoverageMap& operator=(const CoverageMap&) =default;
+		CoverageMap& operator=(CoverageMap&&) =default;
+
+		~CoverageMap() =default;
+
+		// Merges a classified map; reports a new edge over a new hit-count bucket of a known edge.
+		Novelty merge(const EdgeCoverage& coverage) noexcept
+		{
+			const auto& map = coverage.map();
+
+			auto novelty = Novelty::none;
+
+			for (std::size_t i = 0; i < EdgeCoverage::mapSize; i++)
+			{
+				if (const auto fresh = static_cast<std::uint8_t>(map[i] & ~m_seen[i]); fresh != 0)
+				{
+					novelty = std::max(novelty, m_seen[i] == 0 ? Novelty::edge : Novelty::hitCount);
+					m_seen[i] |= fresh;
+				}
+			}
+
+			return novelty;
+		}
+
+		[[nodiscard]]
+		std::size_t edges() const noexcept
+		{
+			return static_cast<std::size_t>(std::count_if(std::begin(m_seen), std::end(m_seen), [](auto bits)
+			{
+				return bits != 0;
+			}));
+		}
+
+	private:
+		std::vector<std::uint8_t> m_seen;
+	};
+}
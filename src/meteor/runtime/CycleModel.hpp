@@ -0,0 +1,251 @@
+/*================================================================================
+ * The MIT License
+ *
+ * Copyright (c) 2018 Ryooooooga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+================================================================================*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <istream>
+#include <numeric>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/format.hpp>
+
+#include "Observer.hpp"
+#include "../Operation.hpp"
+#include "../SymbolMap.hpp"
+
+namespace meteor::runtime
+{
+	// Cycles of an instruction: base cost of its opcode + word × words + memory × data accesses,
+	// plus shift × bits for the shift instructions.
+	struct CycleCosts
+	{
+		std::array<std::uint32_t, 256> base;
+		std::uint32_t word;
+		std::uint32_t memory;
+		std::uint32_t shift;
+
+		explicit CycleCosts()
+			: base()
+			, word(1)
+			, memory(2)
+			, shift(1)
+		{
+			base.fill(1);
+		}
+
+		// Reads `word N', `memory N', `shift N' and `opcode XX N' (XX in hex) lines; `#' starts a comment.
+		[[nodiscard]]
+		static CycleCosts load(std::istream& stream)
+		{
+			CycleCosts costs {};
+
+			std::string line;
+
+			for (std::size_t number = 1; std::getline(stream, line); number++)
+			{
+				std::istringstream fields { line.substr(0, line.find('#')) };
+				std::string key;
+
+				if (!(fields >> key))
+				{
+					continue;
+				}
+
+				bool valid = false;
+
+				if (key == u8"word")
+				{
+					valid = static_cast<bool>(fields >> costs.word);
+				}
+				else if (key == u8"memory")
+				{
+					valid = static_cast<bool>(fields >> costs.memory);
+				}
+				else if (key == u8"shift")
+				{
+					valid = static_cast<bool>(fields >> costs.shift);
+				}
+				else if (key == u8"opcode")
+				{
+					unsigned int opcode = 0;
+					std::uint32_t value = 0;
+
+					valid = (fields >> std::hex >> opcode >> std::dec >> value) && opcode < costs.base.size();
+
+					if (valid)
+					{
+						costs.base[opcode] = value;
+					}
+				}
+
+				if (!valid)
+				{
+					throw std::runtime_error { (boost::format(u8"cycle costs(%1%): invalid line `%2%'.") % number % line).str() };
+				}
+			}
+
+			return costs;
+		}
+	};
+
+	// Accumulates the cycles of the CycleCosts model per instruction address.
+	class CycleCounter
+		: public NullObserver
+	{
+	public:
+		explicit CycleCounter(const CycleCosts& costs = CycleCosts {})
+			: m_costs()
+			, m_shift(costs.shift)
+			, m_cycles(addressSpace, 0)
+			, m_steps(addressSpace, 0)
+			, m_total(0)
+		{
+			for (std::size_t opcode = 0; opcode < m_costs.size(); opcode++)
+			{
+				const auto code = static_cast<Word>(opcode << 8);
+
+				m_costs[opcode] = costs.base[opcode] + costs.word * operations::length(code) + costs.memory * operations::memoryAccesses(code);
+			}
+		}
+
+		// Uncopyable, movable.
+		CycleCounter(const CycleCounter&) =delete;
+		CycleCounter(CycleCounter&&) =default;
+
+		CycleCounter& operator=(const CycleCounter&) =delete;
+		CycleCounter& operator=(CycleCounter&&) =default;
+
+		~CycleCounter() =default;
+
+		template <typename Processor>
+		void onStep(const Processor& processor, Word pc, Word instruction)
+		{
+			std::uint64_t cycles = m_costs[instruction >> 8];
+
+			if ((operations::operationCode(instruction) & 0xf000) == 0x5000)
+			{
+				// The shift count is the effective address.
+				const auto x = operations::registers(instruction).second;
+				const auto count = static_cast<Word>(processor.memory()->read(static_cast<Word>(pc + 1)) + processor.getRegister(x));
+
+				cycles += static_cast<std::uint64_t>(m_shift) * count;
+			}
+
+			m_cycles[pc] += cycles;
+			m_steps[pc]++;
+			m_total += cycles;
+		}
+
+		[[nodiscard]]
+		std::uint64_t cycleCount([[maybe_unused]] std::uint64_t steps) const noexcept
+		{
+			return m_total;
+		}
+
+		[[nodiscard]]
+		std::uint64_t cycles() const noexcept
+		{
+			return m_total;
+		}
+
+		[[nodiscard]]
+		std::uint64_t cycles(Word pc) const noexcept
+		{
+			return m_cycles[pc];
+		}
+
+		struct FunctionCost
+		{
+			std::string name;
+			std::uint64_t steps;
+			std::uint64_t cycles;
+		};
+
+		// Exclusive steps and cycles of each function, sorted by cycles.
+		[[nodiscard]]
+		std::vector<FunctionCost> functions(const SymbolMap& symbolMap) const
+		{
+			std::vector<FunctionCost> costs;
+
+			for (const auto& f : symbolMap.functions())
+			{
+				costs.emplace_back(FunctionCost { f.name, sum(m_steps, f.start, f.end), sum(m_cycles, f.start, f.end) });
+			}
+
+			const auto steps = std::accumulate(std::begin(m_steps), std::end(m_steps), std::uint64_t {0});
+			const auto cycles = this->cycles();
+			auto unknown = FunctionCost { u8"[unknown]", steps, cycles };
+
+			for (const auto& c : costs)
+			{
+				unknown.steps -= c.steps;
+				unknown.cycles -= c.cycles;
+			}
+
+			if (unknown.steps > 0)
+			{
+				costs.emplace_back(unknown);
+			}
+
+			std::stable_sort(std::begin(costs), std::end(costs), [](const auto& a, const auto& b)
+			{
+				return a.cycles > b.cycles;
+			});
+
+			return costs;
+		}
+
+		void report(std::ostream& stream, const SymbolMap& symbolMap) const
+		{
+			stream << boost::format(u8"%1$-24s %2$14s %3$14s %4$8s") % u8"function" % u8"steps" % u8"cycles" % u8"CPI" << std::endl;
+
+			for (const auto& f : functions(symbolMap))
+			{
+				stream << boost::format(u8"%1$-24s %2$14d %3$14d %4$8.2f") % f.name % f.steps % f.cycles % (static_cast<double>(f.cycles) / std::max(f.steps, std::uint64_t {1})) << std::endl;
+			}
+		}
+
+	private:
+		constexpr static std::size_t addressSpace = 65536;
+
+		[[nodiscard]]
+		static std::uint64_t sum(const std::vector<std::uint64_t>& counts, Word begin, Word end) noexcept
+		{
+			return std::accumulate(std::begin(counts) + begin, std::begin(counts) + end, std::uint64_t {0});
+		}
+
+		std::array<std::uint64_t, 256> m_costs;
+		std::uint32_t m_shift;
+		std::vector<std::uint64_t> m_cycles;
+		std::vector<std::uint64_t> m_steps;
+		std::uint64_t m_total;
+	};
+}
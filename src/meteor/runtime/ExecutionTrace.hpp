@@ -0,0 +1,605 @@
+/*================================================================================
+ * The MIT License
+ *
+ * Copyright (c) 2018 Ryooooooga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+================================================================================*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "Observer.hpp"
+#include "../Operation.hpp"
+#include "../Register.hpp"
+
+// Execution trace format, after the signature and the keyframe interval:
+//
+//   keyframe: 0x08, varint record index, u16 next PC, u16 × 10 registers (GR0-GR7, SP, FR)
+//   record:   flags, [zigzag PC delta], [u16 instruction], [register changes], [memory writes]
+//   index:    0x18, varint count, then varint record index and varint byte offset of each keyframe
+//   trailer:  u64 byte offset of the index, "METEORIX"
+//
+// The flags byte holds
+//   bit 0     the PC differs from the address following the previous instruction
+//   bit 1     the instruction differs from the one last seen at the PC (since the keyframe)
+//   bit 2     memory writes follow: varint count, then zigzag address delta and varint value each
+//   bit 3     set only in a keyframe or index tag
+//   bits 4-7  0 if no register changed, 1-10 for a single changed register, 15 for a varint mask;
+//             each changed register is followed by a zigzag delta
+// Decoding can start at any keyframe, which resets every delta. The index and the trailer are written
+// when the recording finishes, so that a reader can seek to a keyframe. Integers are little-endian;
+// varints are LEB128.
+namespace meteor::runtime::execution_trace
+{
+	constexpr char signature[8] = { 'M', 'E', 'T', 'E', 'O', 'R', 'E', 'T' };
+	constexpr char indexSignature[8] = { 'M', 'E', 'T', 'E', 'O', 'R', 'I', 'X' };
+
+	constexpr std::size_t trackedRegisters = 10;
+
+	constexpr unsigned char jumpFlag = 0x01;
+	constexpr unsigned char instructionFlag = 0x02;
+	constexpr unsigned char writesFlag = 0x04;
+	constexpr unsigned char keyframeTag = 0x08;
+	constexpr unsigned char indexTag = 0x18;
+	constexpr unsigned char maskCode = 0x0f;
+
+	// PC is implied by the instruction stream, so it is not a tracked register.
+	[[nodiscard]]
+	constexpr Register trackedRegister(std::size_t index) noexcept
+	{
+		return static_cast<Register>(index < 9 ? index : 10);
+	}
+
+	[[nodiscard]]
+	constexpr std::uint16_t zigzag(Word delta) noexcept
+	{
+		const auto d = static_cast<std::int16_t>(delta);
+
+		return static_cast<std::uint16_t>((d << 1) ^ (d >> 15));
+	}
+
+	[[nodiscard]]
+	constexpr Word unzigzag(std::uint64_t value) noexcept
+	{
+		return static_cast<Word>((value >> 1) ^ (~(value & 1) + 1));
+	}
+}
+
+namespace meteor::runtime
+{
+	// Writes the register changes and memory writes of every retired instruction as a compact binary stream.
+	class ExecutionTraceRecorder
+		: public NullObserver
+	{
+	public:
+		explicit ExecutionTraceRecorder(std::ostream& stream, std::uint64_t keyframeInterval = 65536)
+			: m_stream(&stream)
+			, m_keyframeInterval(std::max(keyframeInterval, std::uint64_t {1}))
+			, m_buffer()
+			, m_records(0)
+			, m_registers()
+			, m_nextPc(0)
+			, m_pc(0)
+			, m_instruction(0)
+			, m_lastAddress(0)
+			, m_writes()
+			, m_instructions(65536, 0)
+			, m_offset(sizeof(execution_trace::signature))
+			, m_keyframes()
+			, m_finished(false)
+		{
+			m_buffer.reserve(bufferSize * 2);
+			m_writes.reserve(64);
+
+			m_stream->write(execution_trace::signature, sizeof(execution_trace::signature));
+			writeVarint(m_keyframeInterval);
+		}
+
+		// Uncopyable, unmovable.
+		ExecutionTraceRecorder(const ExecutionTraceRecorder&) =delete;
+		ExecutionTraceRecorder(ExecutionTraceRecorder&&) =delete;
+
+		ExecutionTraceRecorder& operator=(const ExecutionTraceRecorder&) =delete;
+		ExecutionTraceRecorder& operator=(ExecutionTraceRecorder&&) =delete;
+
+		~ExecutionTraceRecorder()
+		{
+			finish();
+		}
+
+		template <typename Processor>
+		void onStep(const Processor& processor, Word pc, Word instruction)
+		{
+			if (m_records % m_keyframeInterval == 0)
+			{
+				writeKeyframe(processor, pc);
+			}
+
+			m_pc = pc;
+			m_instruction = instruction;
+		}
+
+		void onMemoryWrite(Word address, [[maybe_unused]] Word previous, Word value)
+		{
+			m_writes.emplace_back(address, value);
+		}
+
+		template <typename Processor>
+		void onRetire(const Processor& processor)
+		{
+			using namespace execution_trace;
+
+			const auto flagsAt = m_buffer.size();
+
+			m_buffer.emplace_back(0);
+
+			unsigned char flags = 0;
+
+			if (m_pc != m_nextPc)
+			{
+				flags |= jumpFlag;
+				writeVarint(zigzag(static_cast<Word>(m_pc - m_nextPc)));
+			}
+
+			if (m_instructions[m_pc] != m_instruction)
+			{
+				flags |= instructionFlag;
+				m_instructions[m_pc] = m_instruction;
+				writeWord(m_instruction);
+			}
+
+			std::uint16_t mask = 0;
+			std::array<Word, trackedRegisters> deltas;
+
+			for (std::size_t i = 0; i < trackedRegisters; i++)
+			{
+				const auto value = processor.getRegister(trackedRegister(i));
+
+				deltas[i] = static_cast<Word>(value - m_registers[i]);
+				mask |= (deltas[i] != 0) << i;
+				m_registers[i] = value;
+			}
+
+			if (mask != 0)
+			{
+				if ((mask & (mask - 1)) == 0)
+				{
+					std::size_t i = 0;
+
+					while (deltas[i] == 0)
+					{
+						i++;
+					}
+
+					flags |= static_cast<unsigned char>((i + 1) << 4);
+					writeVarint(zigzag(deltas[i]));
+				}
+				else
+				{
+					flags |= maskCode << 4;
+					writeVarint(mask);
+
+					for (std::size_t i = 0; i < trackedRegisters; i++)
+					{
+						if (mask & (1 << i))
+						{
+							writeVarint(zigzag(deltas[i]));
+						}
+					}
+				}
+			}
+
+			if (!m_writes.empty())
+			{
+				flags |= writesFlag;
+				writeVarint(m_writes.size());
+
+				for (const auto& [address, value] : m_writes)
+				{
+					writeVarint(zigzag(static_cast<Word>(address - m_lastAddress)));
+					writeVarint(value);
+					m_lastAddress = address;
+				}
+
+				m_writes.clear();
+			}
+
+			m_buffer[flagsAt] = flags;
+			m_nextPc = static_cast<Word>(m_pc + operations::length(m_instruction));
+			m_records++;
+
+			if (m_buffer.size() >= bufferSize)
+			{
+				flush();
+			}
+		}
+
+		void flush()
+		{
+			m_stream->write(reinterpret_cast<const char*>(m_buffer.data()), static_cast<std::streamsize>(m_buffer.size()));
+			m_stream->flush();
+			m_offset += m_buffer.size();
+			m_buffer.clear();
+		}
+
+		// Writes the keyframe index and the trailer; no record may follow.
+		void finish()
+		{
+			if (std::exchange(m_finished, true))
+			{
+				return;
+			}
+
+			const auto index = m_offset + m_buffer.size();
+
+			m_buffer.emplace_back(execution_trace::indexTag);
+			writeVarint(m_keyframes.size());
+
+			for (const auto& [record, offset] : m_keyframes)
+			{
+				writeVarint(record);
+				writeVarint(offset);
+			}
+
+			for (int shift = 0; shift < 64; shift += 8)
+			{
+				m_buffer.emplace_back(static_cast<unsigned char>(index >> shift));
+			}
+
+			m_buffer.insert(std::end(m_buffer), std::begin(execution_trace::indexSignature), std::end(execution_trace::indexSignature));
+
+			flush();
+		}
+
+		[[nodiscard]]
+		std::uint64_t records() const noexcept
+		{
+			return m_records;
+		}
+
+	private:
+		constexpr static std::size_t bufferSize = 1 << 16;
+
+		template <typename Processor>
+		void writeKeyframe(const Processor& processor, Word pc)
+		{
+			m_keyframes.emplace_back(m_records, m_offset + m_buffer.size());
+			m_buffer.emplace_back(execution_trace::keyframeTag);
+			writeVarint(m_records);
+			writeWord(pc);
+
+			for (std::size_t i = 0; i < execution_trace::trackedRegisters; i++)
+			{
+				m_registers[i] = processor.getRegister(execution_trace::trackedRegister(i));
+				writeWord(m_registers[i]);
+			}
+
+			m_nextPc = pc;
+			m_lastAddress = 0;
+			std::fill(std::begin(m_instructions), std::end(m_instructions), 0);
+		}
+
+		void writeWord(Word word)
+		{
+			m_buffer.emplace_back(static_cast<unsigned char>(word));
+			m_buffer.emplace_back(static_cast<unsigned char>(word >> 8));
+		}
+
+		void writeVarint(std::uint64_t value)
+		{
+			while (value >= 0x80)
+			{
+				m_buffer.emplace_back(static_cast<unsigned char>(value | 0x80));
+				value >>= 7;
+			}
+
+			m_buffer.emplace_back(static_cast<unsigned char>(value));
+		}
+
+		std::ostream* m_stream;
+		std::uint64_t m_keyframeInterval;
+		std::vector<unsigned char> m_buffer;
+		std::uint64_t m_records;
+		std::array<Word, execution_trace::trackedRegisters> m_registers;
+		Word m_nextPc;
+		Word m_pc;
+		Word m_instruction;
+		Word m_lastAddress;
+		std::vector<std::pair<Word, Word>> m_writes;
+		std::vector<Word> m_instructions;
+		// Bytes handed to the stream.
+		std::uint64_t m_offset;
+		// Record index and byte offset of every keyframe.
+		std::vector<std::pair<std::uint64_t, std::uint64_t>> m_keyframes;
+		bool m_finished;
+	};
+
+	// Decodes a stream written by ExecutionTraceRecorder.
+	class ExecutionTraceReader
+	{
+	public:
+		struct Record
+		{
+			std::uint64_t index;
+			Word pc;
+			Word instruction;
+			// After the instruction; GR0-GR7, SP and FR only.
+			std::array<Word, execution_trace::trackedRegisters> registers;
+			std::uint16_t changed;
+			std::vector<std::pair<Word, Word>> writes;
+		};
+
+		explicit ExecutionTraceReader(std::istream& stream)
+			: m_stream(stream.rdbuf())
+			, m_keyframeInterval(0)
+			, m_keyframes(0)
+			, m_index(0)
+			, m_registers()
+			, m_nextPc(0)
+			, m_lastAddress(0)
+			, m_instructions(65536, 0)
+		{
+			char magic[sizeof(execution_trace::signature)] {};
+
+			for (auto& c : magic)
+			{
+				c = static_cast<char>(readByte());
+			}
+
+			if (!std::equal(std::begin(magic), std::end(magic), std::begin(execution_trace::signature)))
+			{
+				throw std::runtime_error { u8"invalid execution trace." };
+			}
+
+			m_keyframeInterval = readVarint();
+		}
+
+		// Uncopyable, movable.
+		ExecutionTraceReader(const ExecutionTraceReader&) =delete;
+		ExecutionTraceReader(ExecutionTraceReader&&) =default;
+
+		ExecutionTraceReader& operator=(const ExecutionTraceReader&) =delete;
+		ExecutionTraceReader& operator=(ExecutionTraceReader&&) =default;
+
+		~ExecutionTraceReader() =default;
+
+		// Decodes the next record; returns false at the end of the stream.
+		bool next(Record& record)
+		{
+			using namespace execution_trace;
+
+			if (m_stream->sgetc() == std::char_traits<char>::eof())
+			{
+				return false;
+			}
+
+			auto flags = readByte();
+
+			if (flags == indexTag)
+			{
+				m_stream->pubseekoff(0, std::ios::end, std::ios::in);
+
+				return false;
+			}
+
+			if (flags == keyframeTag)
+			{
+				readKeyframe();
+
+				return next(record);
+			}
+
+			record.index = m_index++;
+			record.pc = m_nextPc;
+
+			if (flags & jumpFlag)
+			{
+				record.pc = static_cast<Word>(record.pc + unzigzag(readVarint()));
+			}
+
+			if (flags & instructionFlag)
+			{
+				m_instructions[record.pc] = readWord();
+			}
+
+			record.instruction = m_instructions[record.pc];
+			record.changed = 0;
+
+			if (const auto code = flags >> 4; code == maskCode)
+			{
+				record.changed = static_cast<std::uint16_t>(readVarint());
+			}
+			else if (code != 0)
+			{
+				record.changed = static_cast<std::uint16_t>(1 << (code - 1));
+			}
+
+			for (std::size_t i = 0; i < trackedRegisters; i++)
+			{
+				if (record.changed & (1 << i))
+				{
+					m_registers[i] = static_cast<Word>(m_registers[i] + unzigzag(readVarint()));
+				}
+			}
+
+			record.registers = m_registers;
+			record.writes.clear();
+
+			if (flags & writesFlag)
+			{
+				for (auto count = readVarint(); count > 0; count--)
+				{
+					const auto address = static_cast<Word>(m_lastAddress + unzigzag(readVarint()));
+
+					record.writes.emplace_back(address, static_cast<Word>(readVarint()));
+					m_lastAddress = address;
+				}
+			}
+
+			m_nextPc = static_cast<Word>(record.pc + operations::length(record.instruction));
+
+			return true;
+		}
+
+		// Moves to the last keyframe at or before record `index', so that next() continues from there.
+		// Returns false, without moving, if the stream cannot seek or the trace has no index.
+		bool seek(std::uint64_t index)
+		{
+			using namespace execution_trace;
+
+			const auto failed = std::streampos { std::streamoff { -1 } };
+			constexpr auto trailerSize = std::streamoff { 8 + sizeof(indexSignature) };
+
+			const auto position = m_stream->pubseekoff(0, std::ios::cur, std::ios::in);
+
+			if (position == failed || m_stream->pubseekoff(-trailerSize, std::ios::end, std::ios::in) == failed)
+			{
+				return false;
+			}
+
+			std::uint64_t offset = 0;
+
+			for (int shift = 0; shift < 64; shift += 8)
+			{
+				offset |= std::uint64_t { readByte() } << shift;
+			}
+
+			char magic[sizeof(indexSignature)] {};
+
+			for (auto& c : magic)
+			{
+				c = static_cast<char>(readByte());
+			}
+
+			if (!std::equal(std::begin(magic), std::end(magic), std::begin(indexSignature))
+				|| m_stream->pubseekpos(static_cast<std::streamoff>(offset), std::ios::in) == failed
+				|| readByte() != indexTag)
+			{
+				m_stream->pubseekpos(position, std::ios::in);
+
+				return false;
+			}
+
+			auto target = std::optional<std::uint64_t> {};
+
+			for (auto count = readVarint(); count > 0; count--)
+			{
+				const auto record = readVarint();
+				const auto at = readVarint();
+
+				if (record <= index)
+				{
+					target = at;
+				}
+			}
+
+			m_stream->pubseekpos(target ? std::streampos { static_cast<std::streamoff>(*target) } : position, std::ios::in);
+
+			return true;
+		}
+
+		[[nodiscard]]
+		std::uint64_t keyframeInterval() const noexcept
+		{
+			return m_keyframeInterval;
+		}
+
+		[[nodiscard]]
+		std::uint64_t keyframes() const noexcept
+		{
+			return m_keyframes;
+		}
+
+	private:
+		void readKeyframe()
+		{
+			m_index = readVarint();
+			m_nextPc = readWord();
+
+			for (auto& r : m_registers)
+			{
+				r = readWord();
+			}
+
+			m_lastAddress = 0;
+			std::fill(std::begin(m_instructions), std::end(m_instructions), 0);
+			m_keyframes++;
+		}
+
+		[[nodiscard]]
+		unsigned char readByte()
+		{
+			const auto c = m_stream->sbumpc();
+
+			if (c == std::char_traits<char>::eof())
+			{
+				throw std::runtime_error { u8"truncated execution trace." };
+			}
+
+			return static_cast<unsigned char>(c);
+		}
+
+		[[nodiscard]]
+		Word readWord()
+		{
+			const Word low = readByte();
+
+			return static_cast<Word>(low | (readByte() << 8));
+		}
+
+		[[nodiscard]]
+		std::uint64_t readVarint()
+		{
+			std::uint64_t value = 0;
+
+			for (int shift = 0; shift < 64; shift += 7)
+			{
+				const auto c = readByte();
+
+				value |= static_cast<std::uint64_t>(c & 0x7f) << shift;
+
+				if ((c & 0x80) == 0)
+				{
+					return value;
+				}
+			}
+
+			throw std::runtime_error { u8"invalid execution trace." };
+		}
+
+		std::streambuf* m_stream;
+		std::uint64_t m_keyframeInterval;
+		std::uint64_t m_keyframes;
+		std::uint64_t m_index;
+		std::array<Word, execution_trace::trackedRegisters> m_registers;
+		Word m_nextPc;
+		Word m_lastAddress;
+		std::vector<Word> m_instructions;
+	};
+}
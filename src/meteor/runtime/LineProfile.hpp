@@ -0,0 +1,168 @@
+/*================================================================================
+ * The MIT License
+ *
+ * Copyright (c) 2018 Ryooooooga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+================================================================================*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+#include <boost/format.hpp>
+
+#include "Profiler.hpp"
+#include "../LineTable.hpp"
+
+namespace meteor::runtime
+{
+	// Per-source-line instruction counts, aggregated from a Profiler through the compiler's line table.
+	// The last run ends with the image of `imageSize` words; instructions executed past it belong to no line.
+	class LineProfile
+	{
+	public:
+		explicit LineProfile(const Profiler& profiler, const LineTable& lineTable, std::size_t imageSize)
+			: m_counts()
+		{
+			const auto& counts = profiler.counts();
+			const auto& runs = lineTable.runs();
+			const auto limit = std::min(imageSize, counts.size());
+
+			for (std::size_t i = 0; i < runs.size(); i++)
+			{
+				const std::size_t start = std::min<std::size_t>(runs[i].start, limit);
+				const std::size_t end = i + 1 < runs.size() ? std::min<std::size_t>(runs[i + 1].start, limit) : limit;
+				const auto line = runs[i].line;
+
+				if (line >= m_counts.size())
+				{
+					m_counts.resize(line + 1, 0);
+				}
+
+				m_counts[line] += std::accumulate(std::begin(counts) + start, std::begin(counts) + end, std::uint64_t {0});
+			}
+		}
+
+		// Copyable, movable.
+		LineProfile(const LineProfile&) =default;
+		LineProfile(LineProfile&&) =default;
+
+		LineProfile& operator=(const LineProfile&) =default;
+		LineProfile& operator=(LineProfile&&) =default;
+
+		~LineProfile() =default;
+
+		// Instructions retired on the line; line 0 is compiler-generated code.
+		[[nodiscard]]
+		std::uint64_t count(std::size_t line) const noexcept
+		{
+			return line < m_counts.size() ? m_counts[line] : 0;
+		}
+
+		[[nodiscard]]
+		std::uint64_t total() const noexcept
+		{
+			return std::accumulate(std::begin(m_counts), std::end(m_counts), std::uint64_t {0});
+		}
+
+		// Prints the `top' hottest lines, followed by the annotated source.
+		void report(std::ostream& stream, std::string_view source, std::size_t top = 10) const
+		{
+			const auto sum = std::max(total(), std::uint64_t {1});
+			const auto lines = split(source);
+
+			std::vector<std::size_t> hottest;
+
+			for (std::size_t line = 0; line < m_counts.size(); line++)
+			{
+				if (m_counts[line] > 0)
+				{
+					hottest.emplace_back(line);
+				}
+			}
+
+			std::stable_sort(std::begin(hottest), std::end(hottest), [&](std::size_t a, std::size_t b)
+			{
+				return m_counts[a] > m_counts[b];
+			});
+
+			hottest.resize(std::min(top, hottest.size()));
+
+			stream << u8"hot lines:" << std::endl;
+
+			for (const auto line : hottest)
+			{
+				stream << boost::format(u8"%1$12d %2$6.2f%% %3$5d: %4%") % m_counts[line] % (100.0 * m_counts[line] / sum) % line % text(lines, line) << std::endl;
+			}
+
+			stream << std::endl << u8"annotated source:" << std::endl;
+
+			for (std::size_t line = 1; line <= lines.size(); line++)
+			{
+				if (count(line) > 0)
+				{
+					stream << boost::format(u8"%1$12d %2$6.2f%% ") % m_counts[line] % (100.0 * m_counts[line] / sum);
+				}
+				else
+				{
+					stream << std::string(21, ' ');
+				}
+
+				stream << boost::format(u8"%1$5d: %2%") % line % lines[line - 1] << std::endl;
+			}
+		}
+
+	private:
+		[[nodiscard]]
+		static std::vector<std::string_view> split(std::string_view source)
+		{
+			std::vector<std::string_view> lines;
+
+			while (!source.empty())
+			{
+				const auto newline = source.find('\n');
+
+				lines.emplace_back(source.substr(0, newline));
+
+				if (newline == std::string_view::npos)
+				{
+					break;
+				}
+
+				source.remove_prefix(newline + 1);
+			}
+
+			return lines;
+		}
+
+		[[nodiscard]]
+		static std::string_view text(const std::vector<std::string_view>& lines, std::size_t line) noexcept
+		{
+			return 1 <= line && line <= lines.size() ? lines[line - 1] : u8"<startup>";
+		}
+
+		std::vector<std::uint64_t> m_counts;
+	};
+}
@@ -0,0 +1,274 @@
+/*================================================================================
+ * The MIT License
+ *
+ * Copyright (c) 2018 Ryooooooga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+================================================================================*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <boost/format.hpp>
+
+#include "Memory.hpp"
+#include "Observer.hpp"
+#include "../Disassembler.hpp"
+#include "../Operation.hpp"
+#include "../Register.hpp"
+
+namespace meteor::runtime
+{
+	// Points at which the lockstep harness compares the two engines.
+	enum class Granularity
+	{
+		step,  // After every instruction the candidate retires.
+		block, // After control transfers: jumps, CALL, RET and SVC.
+		exit,  // Once, when both engines stop.
+	};
+
+	struct Divergence
+	{
+		struct Instruction
+		{
+			std::uint64_t step;
+			Word pc;
+			Word code;
+			Word operand;
+		};
+
+		std::uint64_t step;
+		std::string what;
+		// The last instructions retired by the reference, oldest first.
+		std::vector<Instruction> context;
+
+		void print(std::ostream& stream) const
+		{
+			stream << boost::format(u8"divergence at step %1%: %2%") % step % what << std::endl;
+
+			for (const auto& i : context)
+			{
+				stream << boost::format(u8"  %1$10d  #%2$04X: %3%") % i.step % i.pc % operations::disassemble(i.code, i.operand) << std::endl;
+			}
+		}
+	};
+
+	// Runs a candidate engine in lockstep with the reference processor observed by the harness, and
+	// compares the registers, FR and the memory written by the reference at the chosen granularity.
+	// Memory is compared in full and the exit statuses are compared when both engines stop.
+	//
+	//     auto harness = Lockstep { Granularity::block };
+	//     auto reference = BasicProcessor { referenceMemory, harness };
+	//     auto divergence = harness.run(reference, candidate, [](auto& p) { return p.step(); }, budget);
+	//
+	// `advance' may retire several instructions at once; the reference catches up after each call.
+	class Lockstep
+		: public NullObserver
+	{
+	public:
+		explicit Lockstep(Granularity granularity, std::size_t context = 8)
+			: m_granularity(granularity)
+			, m_context(context)
+			, m_history()
+			, m_dirty(0x10000, false)
+			, m_written()
+			, m_transfer(false)
+		{
+		}
+
+		template <typename Processor>
+		void onStep(const Processor& processor, Word pc, Word instruction) noexcept
+		{
+			switch (operations::operationCode(instruction) & 0xf000)
+			{
+				case 0x6000:
+				case 0x8000:
+				case 0xf000:
+					m_transfer = true;
+					break;
+
+				default:
+					m_transfer = false;
+					break;
+			}
+
+			if (m_context == 0)
+			{
+				return;
+			}
+
+			const auto operand = operations::length(instruction) > 1 ? processor.memory()->read(static_cast<Word>(pc + 1)) : Word { 0 };
+			const auto record = Divergence::Instruction { processor.steps(), pc, instruction, operand };
+
+			if (m_history.size() < m_context)
+			{
+				m_history.emplace_back(record);
+			}
+			else
+			{
+				m_history[(processor.steps() - 1) % m_context] = record;
+			}
+		}
+
+		void onMemoryWrite(Word address, [[maybe_unused]] Word previous, [[maybe_unused]] Word value)
+		{
+			if (!m_dirty[address])
+			{
+				m_dirty[address] = true;
+				m_written.emplace_back(address);
+			}
+		}
+
+		// Runs until both engines stop or the candidate has retired `budget` instructions.
+		template <typename Reference, typename Candidate, typename Advance>
+		[[nodiscard]]
+		std::optional<Divergence> run(Reference& reference, Candidate& candidate, Advance advance, std::uint64_t budget)
+		{
+			bool referenceRunning = true;
+			bool candidateRunning = true;
+
+			while (candidateRunning && candidate.steps() < budget)
+			{
+				candidateRunning = advance(candidate);
+
+				while (referenceRunning && reference.steps() < candidate.steps())
+				{
+					referenceRunning = reference.step();
+				}
+
+				if (reference.steps() != candidate.steps())
+				{
+					return diverge(reference.steps(), (boost::format(u8"the reference stopped after %1% steps, the candidate after %2%") % reference.steps() % candidate.steps()).str());
+				}
+
+				if (!referenceRunning || !candidateRunning)
+				{
+					break;
+				}
+
+				if (m_granularity == Granularity::step || (m_granularity == Granularity::block && m_transfer))
+				{
+					if (auto divergence = compare(reference, candidate, false))
+					{
+						return divergence;
+					}
+				}
+			}
+
+			if (referenceRunning != candidateRunning || reference.exitStatus() != candidate.exitStatus())
+			{
+				const auto status = [](const auto& p)
+				{
+					return p.exitStatus() ? (boost::format(u8"exit status %1%") % *p.exitStatus()).str() : std::string { u8"running" };
+				};
+
+				return diverge(reference.steps(), (boost::format(u8"reference %1%, candidate %2%") % status(reference) % status(candidate)).str());
+			}
+
+			return compare(reference, candidate, true);
+		}
+
+	private:
+		template <typename Reference, typename Candidate>
+		[[nodiscard]]
+		std::optional<Divergence> compare(const Reference& reference, const Candidate& candidate, bool full)
+		{
+			for (std::size_t i = 0; i < numRegisters; i++)
+			{
+				const auto r = static_cast<Register>(i);
+				const auto expected = reference.getRegister(r);
+				const auto actual = candidate.getRegister(r);
+
+				if (expected != actual)
+				{
+					return diverge(reference.steps(), (boost::format(u8"%1% reference #%2$04X, candidate #%3$04X") % r % expected % actual).str());
+				}
+			}
+
+			const auto& expected = *reference.memory();
+			const auto& actual = *candidate.memory();
+
+			const auto check = [&](std::size_t address) -> std::optional<Divergence>
+			{
+				if (expected.read(address) != actual.read(address))
+				{
+					return diverge(reference.steps(), (boost::format(u8"memory #%1$04X reference #%2$04X, candidate #%3$04X") % address % expected.read(address) % actual.read(address)).str());
+				}
+
+				return std::nullopt;
+			};
+
+			if (full)
+			{
+				for (std::size_t address = 0; address < expected.size(); address++)
+				{
+					if (auto divergence = check(address))
+					{
+						return divergence;
+					}
+				}
+			}
+			else
+			{
+				for (const auto address : m_written)
+				{
+					if (auto divergence = check(address))
+					{
+						return divergence;
+					}
+				}
+			}
+
+			for (const auto address : m_written)
+			{
+				m_dirty[address] = false;
+			}
+
+			m_written.clear();
+
+			return std::nullopt;
+		}
+
+		[[nodiscard]]
+		Divergence diverge(std::uint64_t step, std::string what) const
+		{
+			auto divergence = Divergence { step, std::move(what), m_history };
+
+			std::sort(std::begin(divergence.context), std::end(divergence.context), [](const auto& a, const auto& b)
+			{
+				return a.step < b.step;
+			});
+
+			return divergence;
+		}
+
+		Granularity m_granularity;
+		std::size_t m_context;
+		std::vector<Divergence::Instruction> m_history;
+		std::vector<bool> m_dirty;
+		std::vector<Word> m_written;
+		bool m_transfer;
+	};
+}
@@ -24,8 +24,11 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <iomanip>
+#include <memory>
 #include <ostream>
 #include <vector>
 
@@ -35,18 +38,24 @@
 
 namespace meteor::runtime
 {
+	// Word-addressed memory.
+	// Every word is accessed atomically with relaxed ordering, so several processors may share one memory.
 	class Memory
 	{
 	public:
 		explicit Memory()
-			: m_data(dataSize, 0)
+			: m_data(std::make_unique<std::atomic<Word>[]>(dataSize))
 		{
 		}
 
-		explicit Memory(std::vector<Word> data)
-			: m_data(std::move(data))
+		// Words of the image past the address space are dropped.
+		explicit Memory(const std::vector<Word>& data)
+			: Memory()
 		{
-			m_data.resize(dataSize);
+			for (std::size_t i = 0; i < std::min(data.size(), dataSize); i++)
+			{
+				write(i, data[i]);
+			}
 		}
 
 		// Uncopyable, movable.
@@ -61,7 +70,7 @@ namespace meteor::runtime
 		[[nodiscard]]
 		std::size_t size() const noexcept
 		{
-			return m_data.size();
+			return dataSize;
 		}
 
 		[[nodiscard]]
@@ -69,14 +78,43 @@ namespace meteor::runtime
 		{
 			assert(position < size());
 
-			return m_data[position];
+			return m_data[position].load(std::memory_order_relaxed);
 		}
 
 		void write(std::size_t position, Word value)
 		{
 			assert(position < size());
 
-			m_data[position] = value;
+			m_data[position].store(value, std::memory_order_relaxed);
+		}
+
+		// Restores [begin, end) from the image, clearing the words past its end.
+		void restore(const std::vector<Word>& image, std::size_t begin, std::size_t end)
+		{
+			assert(begin <= end && end <= size());
+
+			for (auto i = begin; i < end; i++)
+			{
+				write(i, i < image.size() ? image[i] : 0);
+			}
+		}
+
+		// m[position] <- m[position] + value, returns the previous value.
+		Word fetchAdd(std::size_t position, Word value)
+		{
+			assert(position < size());
+
+			return m_data[position].fetch_add(value, std::memory_order_seq_cst);
+		}
+
+		// m[position] <- desired if m[position] == expected, returns the previous value.
+		Word compareExchange(std::size_t position, Word expected, Word desired)
+		{
+			assert(position < size());
+
+			m_data[position].compare_exchange_strong(expected, desired, std::memory_order_seq_cst);
+
+			return expected;
 		}
 
 		void dump(std::ostream& stream)
@@ -141,6 +179,6 @@ namespace meteor::runtime
 	private:
 		constexpr static std::size_t dataSize = 65536;
 
-		std::vector<Word> m_data;
+		std::unique_ptr<std::atomic<Word>[]> m_data;
 	};
 }
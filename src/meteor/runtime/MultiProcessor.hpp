@@ -0,0 +1,190 @@
+/*================================================================================
+ * The MIT License
+ *
+ * Copyright (c) 2018 Ryooooooga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+================================================================================*/
+
+#pragma once
+
+#include <algorithm>
+#include <exception>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "Processor.hpp"
+
+namespace meteor::runtime
+{
+	// Frames of an image that keeps its locals in frames addressed by GR7, as compiled code does.
+	// Each processor gets GR0 = 0 and its own frame region above the one of the previous processor,
+	// and starts at `entry', past the startup code that would have set those registers.
+	// For a compiled image, `entry' and `frameBase' are Compiler::entryPoint() and Compiler::frameBase().
+	struct FrameLayout
+	{
+		Word entry;
+		Word frameBase;
+		Word frameSize = 0x1000;
+	};
+
+	// Several processors sharing one memory.
+	// Each processor starts at PC #0000 with its own stack below the stack of the previous one, unless
+	// a frame layout is given; SVC processorId tells the guest which processor it runs on.
+	class MultiProcessor
+	{
+	public:
+		explicit MultiProcessor(std::shared_ptr<Memory> memory, std::size_t count, Word stackSize = 0x1000, std::optional<FrameLayout> frames = std::nullopt)
+			: m_memory(std::move(memory))
+			, m_processors()
+			, m_running(count, true)
+		{
+			assert(m_memory);
+			assert(count > 0);
+
+			if (frames && frames->frameBase + count * frames->frameSize > 0x10000 - count * stackSize)
+			{
+				throw std::length_error { (boost::format(u8"the frames and stacks of %1% processors do not fit in memory.") % count).str() };
+			}
+
+			m_processors.reserve(count);
+
+			for (std::size_t i = 0; i < count; i++)
+			{
+				auto& processor = m_processors.emplace_back(m_memory);
+
+				processor.id(static_cast<Word>(i));
+				processor.setRegister(Register::stackPointer, static_cast<Word>(0x10000 - i * stackSize));
+
+				if (frames)
+				{
+					processor.setRegister(Register::general0, 0x0000);
+					processor.setRegister(Register::general7, static_cast<Word>(frames->frameBase + i * frames->frameSize));
+					processor.setRegister(Register::programCounter, frames->entry);
+				}
+			}
+		}
+
+		// Uncopyable, movable.
+		MultiProcessor(const MultiProcessor&) =delete;
+		MultiProcessor(MultiProcessor&&) =default;
+
+		MultiProcessor& operator=(const MultiProcessor&) =delete;
+		MultiProcessor& operator=(MultiProcessor&&) =default;
+
+		~MultiProcessor() =default;
+
+		[[nodiscard]]
+		std::size_t size() const noexcept
+		{
+			return m_processors.size();
+		}
+
+		[[nodiscard]]
+		Processor& processor(std::size_t index) noexcept
+		{
+			assert(index < size());
+
+			return m_processors[index];
+		}
+
+		[[nodiscard]]
+		std::shared_ptr<Memory> memory() const noexcept
+		{
+			return m_memory;
+		}
+
+		// Returns true while any processor has not stopped.
+		[[nodiscard]]
+		bool running() const noexcept
+		{
+			return std::find(std::begin(m_running), std::end(m_running), true) != std::end(m_running);
+		}
+
+		// Runs every processor on its own host thread for at most `budget` instructions.
+		void run(std::uint64_t budget)
+		{
+			std::vector<std::thread> threads;
+			std::vector<std::exception_ptr> errors(size());
+
+			threads.reserve(size());
+
+			for (std::size_t i = 0; i < size(); i++)
+			{
+				if (!m_running[i])
+				{
+					continue;
+				}
+
+				threads.emplace_back([this, &errors, i, budget]
+				{
+					try
+					{
+						m_running[i] = m_processors[i].run(budget);
+					}
+					catch (...)
+					{
+						m_running[i] = false;
+						errors[i] = std::current_exception();
+					}
+				});
+			}
+
+			for (auto& thread : threads)
+			{
+				thread.join();
+			}
+
+			for (const auto& error : errors)
+			{
+				if (error)
+				{
+					std::rethrow_exception(error);
+				}
+			}
+		}
+
+		// Runs the processors round-robin on the calling thread, `quantum` instructions at a time,
+		// for at most `budget` instructions each. The interleaving is deterministic.
+		void runLockstep(std::uint64_t budget, std::uint64_t quantum = 1)
+		{
+			assert(quantum > 0);
+
+			for (std::uint64_t executed = 0; executed < budget && running(); executed += quantum)
+			{
+				const auto slice = std::min(quantum, budget - executed);
+
+				for (std::size_t i = 0; i < size(); i++)
+				{
+					if (m_running[i])
+					{
+						m_running[i] = m_processors[i].run(slice);
+					}
+				}
+			}
+		}
+
+	private:
+		std::shared_ptr<Memory> m_memory;
+		std::vector<Processor> m_processors;
+		std::vector<char> m_running;
+	};
+}
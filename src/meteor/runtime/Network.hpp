@@ -0,0 +1,334 @@
+/*================================================================================
+ * The MIT License
+ *
+ * Copyright (c) 2018 Ryooooooga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+================================================================================*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#	include <pthread.h>
+#	include <sched.h>
+#endif
+
+#include "Processor.hpp"
+
+namespace meteor::runtime
+{
+	// Processors (nodes) exchanging messages through channels, each node pinned to one host worker thread.
+	// A node parked at a send or receive is skipped by its worker until the channel is ready.
+	class Network
+	{
+	public:
+		explicit Network(std::size_t workers = std::max(1u, std::thread::hardware_concurrency()))
+			: m_workers(workers)
+			, m_nodes()
+		{
+			assert(m_workers > 0);
+		}
+
+		// Uncopyable, unmovable.
+		Network(const Network&) =delete;
+		Network(Network&&) =delete;
+
+		Network& operator=(const Network&) =delete;
+		Network& operator=(Network&&) =delete;
+
+		~Network() =default;
+
+		[[nodiscard]]
+		std::size_t size() const noexcept
+		{
+			return m_nodes.size();
+		}
+
+		// Adds a node running on the memory, and returns its index (also returned by SVC processorId).
+		std::size_t addNode(std::shared_ptr<Memory> memory)
+		{
+			auto& node = m_nodes.emplace_back(std::make_unique<Node>(std::move(memory)));
+
+			node->processor.id(static_cast<Word>(size() - 1));
+
+			return size() - 1;
+		}
+
+		[[nodiscard]]
+		Processor& processor(std::size_t node) noexcept
+		{
+			assert(node < size());
+
+			return m_nodes[node]->processor;
+		}
+
+		// Connects port `sendPort` of node `from` to port `receivePort` of node `to`.
+		std::shared_ptr<Channel> connect(std::size_t from, Word sendPort, std::size_t to, Word receivePort, std::size_t capacity = 1024)
+		{
+			auto channel = std::make_shared<Channel>(capacity);
+
+			processor(from).outbound(sendPort, channel);
+			processor(to).inbound(receivePort, channel);
+
+			return channel;
+		}
+
+		// Runs every node for at most `budget` more instructions, `quantum` instructions at a time.
+		// A node that has exited is never run again.
+		// Returns false if the run ended because every remaining node waits on a channel that never becomes ready.
+		bool run(std::uint64_t budget, std::uint64_t quantum = 4096)
+		{
+			const auto workers = std::min(m_workers, size());
+
+			m_settled = 0;
+			m_transitions = 0;
+			m_deadlocked = false;
+			m_passes = std::vector<std::atomic<std::uint64_t>>(workers);
+
+			for (const auto& node : m_nodes)
+			{
+				const auto steps = node->processor.steps();
+
+				node->limit = budget > std::numeric_limits<std::uint64_t>::max() - steps ? std::numeric_limits<std::uint64_t>::max() : steps + budget;
+
+				if (!node->running || budget == 0)
+				{
+					node->state = State::stopped;
+				}
+				else
+				{
+					node->state = node->processor.parked() ? State::blocked : State::runnable;
+				}
+
+				if (node->state != State::runnable)
+				{
+					m_settled++;
+				}
+			}
+
+			std::vector<std::thread> threads;
+			std::vector<std::exception_ptr> errors(workers);
+
+			for (std::size_t worker = 0; worker < workers; worker++)
+			{
+				threads.emplace_back([this, &errors, worker, workers, quantum]
+				{
+					try
+					{
+						work(worker, workers, quantum);
+					}
+					catch (...)
+					{
+						errors[worker] = std::current_exception();
+						m_deadlocked = true;
+					}
+
+					m_passes[worker] = finished;
+				});
+
+				pin(threads.back(), worker);
+			}
+
+			for (auto& thread : threads)
+			{
+				thread.join();
+			}
+
+			for (const auto& error : errors)
+			{
+				if (error)
+				{
+					std::rethrow_exception(error);
+				}
+			}
+
+			return !m_deadlocked;
+		}
+
+		// Whether any node has not exited yet.
+		[[nodiscard]]
+		bool running() const noexcept
+		{
+			return std::any_of(std::begin(m_nodes), std::end(m_nodes), [](const auto& node) { return node->running; });
+		}
+
+	private:
+		enum class State
+		{
+			runnable,
+			blocked,
+			stopped,
+		};
+
+		struct Node
+		{
+			explicit Node(std::shared_ptr<Memory> memory)
+				: processor(std::move(memory))
+				, state(State::runnable)
+				, running(true)
+				, limit(0)
+			{
+			}
+
+			Processor processor;
+			State state; // Owned by the worker of the node.
+			bool running; // Cleared once the node exits, never set again.
+			std::uint64_t limit; // Steps at which the current run stops the node.
+		};
+
+		constexpr static std::uint64_t finished = std::numeric_limits<std::uint64_t>::max();
+
+		void work(std::size_t worker, std::size_t workers, std::uint64_t quantum)
+		{
+			// Snapshot of the other workers taken when every node looked settled.
+			std::vector<std::uint64_t> suspicion;
+			std::uint64_t suspectedTransitions = 0;
+
+			while (!m_deadlocked)
+			{
+				bool alive = false;
+				bool progressed = false;
+
+				for (auto i = worker; i < size(); i += workers)
+				{
+					auto& node = *m_nodes[i];
+
+					if (node.state == State::stopped)
+					{
+						continue;
+					}
+
+					alive = true;
+
+					if (!node.processor.ready())
+					{
+						continue;
+					}
+
+					if (node.state == State::blocked)
+					{
+						node.state = State::runnable;
+						m_settled--;
+						m_transitions++;
+					}
+
+					const auto slice = std::min(quantum, node.limit - node.processor.steps());
+
+					node.running = node.processor.run(slice);
+					progressed = true;
+
+					if (!node.running || node.processor.steps() >= node.limit)
+					{
+						node.state = State::stopped;
+						m_settled++;
+					}
+					else if (node.processor.parked())
+					{
+						node.state = State::blocked;
+						m_settled++;
+					}
+				}
+
+				m_passes[worker]++;
+
+				if (!alive)
+				{
+					return;
+				}
+
+				if (progressed)
+				{
+					suspicion.clear();
+					continue;
+				}
+
+				if (suspectDeadlock(suspicion, suspectedTransitions))
+				{
+					m_deadlocked = true;
+					return;
+				}
+
+				std::this_thread::yield();
+			}
+		}
+
+		// Every node is settled, and every worker has rechecked its nodes since without waking any of them.
+		[[nodiscard]]
+		bool suspectDeadlock(std::vector<std::uint64_t>& suspicion, std::uint64_t& suspectedTransitions)
+		{
+			if (m_settled != size())
+			{
+				suspicion.clear();
+				return false;
+			}
+
+			if (suspicion.empty() || m_transitions != suspectedTransitions)
+			{
+				suspicion.clear();
+				suspectedTransitions = m_transitions;
+
+				for (const auto& passes : m_passes)
+				{
+					suspicion.emplace_back(passes);
+				}
+
+				return false;
+			}
+
+			for (std::size_t i = 0; i < m_passes.size(); i++)
+			{
+				if (m_passes[i] != finished && m_passes[i] < suspicion[i] + 2)
+				{
+					return false;
+				}
+			}
+
+			return m_settled == size() && m_transitions == suspectedTransitions;
+		}
+
+		static void pin([[maybe_unused]] std::thread& thread, [[maybe_unused]] std::size_t worker)
+		{
+#ifdef __linux__
+			const auto cpus = std::max(1u, std::thread::hardware_concurrency());
+
+			cpu_set_t set;
+			CPU_ZERO(&set);
+			CPU_SET(worker % cpus, &set);
+
+			// Pinning is best effort.
+			pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+#endif
+		}
+
+		std::size_t m_workers;
+		std::vector<std::unique_ptr<Node>> m_nodes;
+
+		std::atomic<std::size_t> m_settled;
+		std::atomic<std::uint64_t> m_transitions;
+		std::atomic<bool> m_deadlocked;
+		std::vector<std::atomic<std::uint64_t>> m_passes;
+	};
+}
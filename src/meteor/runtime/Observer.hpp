@@ -0,0 +1,78 @@
+/*================================================================================
+ * The MIT License
+ *
+ * Copyright (c) 2018 Ryooooooga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+================================================================================*/
+
+#pragma once
+
+#include <cstdint>
+
+#include "../Type.hpp"
+
+namespace meteor::runtime
+{
+	// Observer of a processor that ignores every event.
+	// Observers derive from it and hide the events they need. Events are dispatched statically,
+	// so an event no observer is interested in costs nothing.
+	class NullObserver
+	{
+	public:
+		// Before the instruction at `pc` is executed.
+		template <typename Processor>
+		void onStep([[maybe_unused]] const Processor& processor, [[maybe_unused]] Word pc, [[maybe_unused]] Word instruction) noexcept
+		{
+		}
+
+		// After the instruction has been executed.
+		template <typename Processor>
+		void onRetire([[maybe_unused]] const Processor& processor) noexcept
+		{
+		}
+
+		// After `value` replaced `previous` at `address`.
+		void onMemoryWrite([[maybe_unused]] Word address, [[maybe_unused]] Word previous, [[maybe_unused]] Word value) noexcept
+		{
+		}
+
+		// A jump instruction at `pc`, whether it was taken or not.
+		void onBranch([[maybe_unused]] Word pc, [[maybe_unused]] Word target, [[maybe_unused]] bool taken) noexcept
+		{
+		}
+
+		// After CALL at `pc` pushed the return address.
+		void onCall([[maybe_unused]] Word pc, [[maybe_unused]] Word target) noexcept
+		{
+		}
+
+		// After RET at `pc` popped the return address `target`.
+		void onReturn([[maybe_unused]] Word pc, [[maybe_unused]] Word target) noexcept
+		{
+		}
+
+		// Cycles retired in `steps` instructions, read by SVC readCycles; one per instruction without a cycle model.
+		[[nodiscard]]
+		std::uint64_t cycleCount(std::uint64_t steps) const noexcept
+		{
+			return steps;
+		}
+	};
+}
@@ -0,0 +1,246 @@
+/*================================================================================
+ * The MIT License
+ *
+ * Copyright (c) 2018 Ryooooooga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+================================================================================*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <boost/format.hpp>
+
+#include "Observer.hpp"
+#include "../Disassembler.hpp"
+
+namespace meteor::runtime
+{
+	// Counts executed opcodes and consecutive opcode pairs, indexed by the high byte of the instruction.
+	class OpcodeStatistics
+		: public NullObserver
+	{
+	public:
+		explicit OpcodeStatistics()
+			: m_opcodes()
+			, m_pairs(opcodes * opcodes, 0)
+			, m_previous(none)
+		{
+		}
+
+		// Uncopyable, movable.
+		OpcodeStatistics(const OpcodeStatistics&) =delete;
+		OpcodeStatistics(OpcodeStatistics&&) =default;
+
+		OpcodeStatistics& operator=(const OpcodeStatistics&) =delete;
+		OpcodeStatistics& operator=(OpcodeStatistics&&) =default;
+
+		~OpcodeStatistics() =default;
+
+		template <typename Processor>
+		void onStep([[maybe_unused]] const Processor& processor, [[maybe_unused]] Word pc, Word instruction) noexcept
+		{
+			const std::size_t opcode = instruction >> 8;
+
+			m_opcodes[opcode]++;
+
+			if (m_previous != none)
+			{
+				m_pairs[m_previous * opcodes + opcode]++;
+			}
+
+			m_previous = opcode;
+		}
+
+		[[nodiscard]]
+		std::uint64_t count(Word opcode) const noexcept
+		{
+			return m_opcodes[opcode >> 8];
+		}
+
+		[[nodiscard]]
+		std::uint64_t count(Word first, Word second) const noexcept
+		{
+			return m_pairs[(first >> 8) * opcodes + (second >> 8)];
+		}
+
+		// One long-format table (RFC 4180): kind,opcode,mnemonic,next_opcode,next_mnemonic,count
+		// where kind is `opcode' (next_* empty) or `pair'.
+		void writeCSV(std::ostream& stream) const
+		{
+			stream << u8"kind,opcode,mnemonic,next_opcode,next_mnemonic,count" << std::endl;
+
+			for (const auto opcode : usedOpcodes())
+			{
+				stream << boost::format(u8"opcode,%1$02X,%2%,,,%3%") % opcode % quote(name(opcode)) % m_opcodes[opcode] << std::endl;
+			}
+
+			for (const auto pair : usedPairs())
+			{
+				const auto first = pair / opcodes;
+				const auto second = pair % opcodes;
+
+				stream << boost::format(u8"pair,%1$02X,%2%,%3$02X,%4%,%5%") % first % quote(name(first)) % second % quote(name(second)) % m_pairs[pair] << std::endl;
+			}
+		}
+
+		void writeJSON(std::ostream& stream) const
+		{
+			stream << u8"{\n  \"opcodes\": [";
+
+			const char* separator = u8"\n";
+
+			for (const auto opcode : usedOpcodes())
+			{
+				stream << separator << boost::format(u8"    {\"opcode\": \"%1$02X\", \"mnemonic\": \"%2%\", \"count\": %3%}") % opcode % name(opcode) % m_opcodes[opcode];
+				separator = u8",\n";
+			}
+
+			stream << u8"\n  ],\n  \"pairs\": [";
+
+			separator = u8"\n";
+
+			for (const auto pair : usedPairs())
+			{
+				stream << separator << boost::format(u8"    {\"first\": \"%1%\", \"second\": \"%2%\", \"count\": %3%}") % name(pair / opcodes) % name(pair % opcodes) % m_pairs[pair];
+				separator = u8",\n";
+			}
+
+			stream << u8"\n  ]\n}" << std::endl;
+		}
+
+	private:
+		constexpr static std::size_t opcodes = 256;
+		constexpr static std::size_t none = opcodes;
+
+		// Mnemonic with the operand form, e.g. `LD r,r' or `LD r,adr'.
+		[[nodiscard]]
+		static std::string name(std::size_t opcode)
+		{
+			const auto code = static_cast<Word>(opcode << 8);
+			const auto mnemonic = operations::mnemonic(code);
+
+			if (mnemonic == nullptr)
+			{
+				return (boost::format(u8"#%1$02X") % opcode).str();
+			}
+
+			switch (operations::operationCode(code))
+			{
+				case operations::ld_adr:
+				case operations::adda_adr:
+				case operations::suba_adr:
+				case operations::addl_adr:
+				case operations::subl_adr:
+				case operations::and_adr:
+				case operations::or_adr:
+				case operations::xor_adr:
+				case operations::cpa_adr:
+				case operations::cpl_adr:
+					return std::string {mnemonic} + u8" r,adr";
+
+				case operations::ld_r:
+				case operations::adda_r:
+				case operations::suba_r:
+				case operations::addl_r:
+				case operations::subl_r:
+				case operations::and_r:
+				case operations::or_r:
+				case operations::xor_r:
+				case operations::cpa_r:
+				case operations::cpl_r:
+					return std::string {mnemonic} + u8" r,r";
+
+				default:
+					return mnemonic;
+			}
+		}
+
+		// Mnemonics contain commas, e.g. `LD r,adr'.
+		[[nodiscard]]
+		static std::string quote(const std::string& field)
+		{
+			std::string quoted = u8"\"";
+
+			for (const auto c : field)
+			{
+				if (c == u8'"')
+				{
+					quoted += c;
+				}
+
+				quoted += c;
+			}
+
+			return quoted + u8"\"";
+		}
+
+		[[nodiscard]]
+		std::vector<std::size_t> usedOpcodes() const
+		{
+			std::vector<std::size_t> used;
+
+			for (std::size_t opcode = 0; opcode < opcodes; opcode++)
+			{
+				if (m_opcodes[opcode] > 0)
+				{
+					used.emplace_back(opcode);
+				}
+			}
+
+			std::stable_sort(std::begin(used), std::end(used), [this](auto a, auto b)
+			{
+				return m_opcodes[a] > m_opcodes[b];
+			});
+
+			return used;
+		}
+
+		[[nodiscard]]
+		std::vector<std::size_t> usedPairs() const
+		{
+			std::vector<std::size_t> used;
+
+			for (std::size_t pair = 0; pair < m_pairs.size(); pair++)
+			{
+				if (m_pairs[pair] > 0)
+				{
+					used.emplace_back(pair);
+				}
+			}
+
+			std::stable_sort(std::begin(used), std::end(used), [this](auto a, auto b)
+			{
+				return m_pairs[a] > m_pairs[b];
+			});
+
+			return used;
+		}
+
+		std::array<std::uint64_t, opcodes> m_opcodes;
+		std::vector<std::uint64_t> m_pairs;
+		std::size_t m_previous;
+	};
+}
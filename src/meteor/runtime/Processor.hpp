@@ -24,93 +24,130 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <cstdint>
 #include <iostream>
+#include <limits>
 #include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
+#include "Channel.hpp"
 #include "Memory.hpp"
+#include "Observer.hpp"
+#include "SystemCallLog.hpp"
+#include "../Interrupt.hpp"
 #include "../Operation.hpp"
 #include "../SystemCall.hpp"
 
 namespace meteor::runtime
 {
-	class Processor
+	template <typename Observer = NullObserver>
+	class BasicProcessor
 	{
 	public:
-		explicit Processor(std::shared_ptr<Memory> memory)
+		explicit BasicProcessor(std::shared_ptr<Memory> memory, Observer& observer = nullObserver())
 			: m_memory(std::move(memory))
+			, m_observer(&observer)
 			, m_registers()
+			, m_id(0)
+			, m_exitStatus()
+			, m_input(&std::cin)
+			, m_output(&std::cout)
+			, m_recordLog(nullptr)
+			, m_replayLog(nullptr)
+			, m_steps(0)
+			, m_instructionBase(0)
+			, m_cycleBase(0)
+			, m_stepLimit(never)
+			, m_timerPeriod(0)
+			, m_timerVector(interrupts::timerVector)
+			, m_nextInterrupt(never)
+			, m_inInterrupt(false)
+			, m_interruptPending(false)
+			, m_outbound()
+			, m_inbound()
+			, m_waitChannel(nullptr)
+			, m_waitSending(false)
 		{
 			assert(m_memory);
 		}
 
 		// Uncopyable, movable.
-		Processor(const Processor&) =delete;
-		Processor(Processor&&) =default;
+		BasicProcessor(const BasicProcessor&) =delete;
+		BasicProcessor(BasicProcessor&&) =default;
 
-		Processor& operator=(const Processor&) =delete;
-		Processor& operator=(Processor&&) =default;
+		BasicProcessor& operator=(const BasicProcessor&) =delete;
+		BasicProcessor& operator=(BasicProcessor&&) =default;
 
-		~Processor() =default;
+		~BasicProcessor() =default;
+
+		// Executes at most `budget` instructions, servicing the timer in between.
+		// Returns false when the program has stopped.
+		bool run(std::uint64_t budget)
+		{
+			const auto end = budget < never - m_steps ? m_steps + budget : never;
+
+			// A parked system call is retried.
+			m_waitChannel = nullptr;
+
+			while (m_steps < end)
+			{
+				// The budget and the next interrupt share one limit, so the inner loop checks nothing else.
+				m_stepLimit = std::min(end, m_nextInterrupt);
+
+				while (m_steps < m_stepLimit)
+				{
+					if (!step())
+					{
+						return false;
+					}
+				}
+
+				if (m_waitChannel)
+				{
+					return true;
+				}
+
+				if (m_steps >= m_nextInterrupt)
+				{
+					raiseTimerInterrupt();
+				}
+			}
+
+			return true;
+		}
 
 		bool step()
 		{
+			const auto pc = programCounter();
 			const auto instruction = fetchProgram();
-			const auto operation = operations::operationCode(instruction);
-			const auto [register1, register2] = operations::registers(instruction);
 
-			switch (operation)
+			// Observers must never see a send or receive that parks, so an observed processor checks before the step is
+			// announced. Without observers executeSVC parks instead, and only SVC pays for the check.
+			if constexpr (!std::is_same_v<Observer, NullObserver>)
 			{
-				// 0x00 ~ 0x0f
-				case operations::nop      : return executeNOP      ();
-				// 0x10 ~ 0x1f
-				case operations::ld_adr   : return executeLD_adr   (register1, fetchProgram(), register2);
-				case operations::st       : return executeST       (register1, fetchProgram(), register2);
-				case operations::lad      : return executeLAD      (register1, fetchProgram(), register2);
-				case operations::ld_r     : return executeLD_r     (register1, register2);
-				// 0x20 ~ 0x2f
-				case operations::adda_adr : return executeADDA_adr (register1, fetchProgram(), register2);
-				case operations::suba_adr : return executeSUBA_adr (register1, fetchProgram(), register2);
-				case operations::addl_adr : return executeADDL_adr (register1, fetchProgram(), register2);
-				case operations::subl_adr : return executeSUBL_adr (register1, fetchProgram(), register2);
-				case operations::adda_r   : return executeADDA_r   (register1, register2);
-				case operations::suba_r   : return executeSUBA_r   (register1, register2);
-				case operations::addl_r   : return executeADDL_r   (register1, register2);
-				case operations::subl_r   : return executeSUBL_r   (register1, register2);
-				// 0x30 ~ 0x3f
-				case operations::and_adr  : return executeAND_adr  (register1, fetchProgram(), register2);
-				case operations::or_adr   : return executeOR_adr   (register1, fetchProgram(), register2);
-				case operations::xor_adr  : return executeXOR_adr  (register1, fetchProgram(), register2);
-				case operations::and_r    : return executeAND_r    (register1, register2);
-				case operations::or_r     : return executeOR_r     (register1, register2);
-				case operations::xor_r    : return executeXOR_r    (register1, register2);
-				// 0x40 ~ 0x4f
-				case operations::cpa_adr  : return executeCPA_adr  (register1, fetchProgram(), register2);
-				case operations::cpl_adr  : return executeCPL_adr  (register1, fetchProgram(), register2);
-				case operations::cpa_r    : return executeCPA_r    (register1, register2);
-				case operations::cpl_r    : return executeCPL_r    (register1, register2);
-				// 0x50 ~ 0x5f
-				case operations::sla_adr  : return executeSLA_adr  (register1, fetchProgram(), register2);
-				case operations::sra_adr  : return executeSRA_adr  (register1, fetchProgram(), register2);
-				case operations::sll_adr  : return executeSLL_adr  (register1, fetchProgram(), register2);
-				case operations::srl_adr  : return executeSRL_adr  (register1, fetchProgram(), register2);
-				// 0x60 ~ 0x6f
-				case operations::jmi      : return executeJMI      (fetchProgram(), register2);
-				case operations::jnz      : return executeJNZ      (fetchProgram(), register2);
-				case operations::jze      : return executeJZE      (fetchProgram(), register2);
-				case operations::jump     : return executeJUMP     (fetchProgram(), register2);
-				case operations::jpl      : return executeJPL      (fetchProgram(), register2);
-				case operations::jov      : return executeJOV      (fetchProgram(), register2);
-				// 0x70 ~ 0x7f
-				case operations::push     : return executePUSH     (fetchProgram(), register2);
-				case operations::pop      : return executePOP      (register1);
-				// 0x80 ~ 0x8f
-				case operations::call     : return executeCALL     (fetchProgram(), register2);
-				case operations::ret      : return executeRET      ();
-				// 0xf0 ~ 0xff
-				case operations::svc      : return executeSVC      (fetchProgram(), register2);
-				default                   : return executeError    (instruction);
+				if (operations::operationCode(instruction) == operations::svc && blocked(systemCallNumber(instruction)))
+				{
+					programCounter(pc);
+					m_stepLimit = m_steps;
+
+					return true;
+				}
 			}
+
+			m_steps++;
+
+			m_observer->onStep(*this, pc, instruction);
+
+			const auto running = execute(instruction);
+
+			m_observer->onRetire(*this);
+
+			return running;
 		}
 
 		[[nodiscard]]
@@ -119,25 +156,26 @@ namespace meteor::runtime
 			return m_memory;
 		}
 
-		void dumpRegisters(std::ostream& stream)
+		[[nodiscard]]
+		std::istream& input() const noexcept
 		{
-			for (Word i = 0; i < numRegisters; i++)
-			{
-				stream << boost::format("%1$3s = #%2$04X = %2$d") % static_cast<Register>(i) % m_registers[i] << std::endl;
-			}
+			return *m_input;
 		}
 
-	private:
-		[[nodiscard]]
-		constexpr static bool msb(Word value) noexcept
+		void input(std::istream& stream) noexcept
 		{
-			return (value & 0x8000) != 0;
+			m_input = &stream;
 		}
 
 		[[nodiscard]]
-		constexpr static bool lsb(Word value) noexcept
+		std::ostream& output() const noexcept
 		{
-			return (value & 0x0001) != 0;
+			return *m_output;
+		}
+
+		void output(std::ostream& stream) noexcept
+		{
+			m_output = &stream;
 		}
 
 		[[nodiscard]]
@@ -151,6 +189,134 @@ namespace meteor::runtime
 			m_registers[static_cast<Word>(reg)] = value;
 		}
 
+		// Index of the processor in a multi-processor machine.
+		[[nodiscard]]
+		Word id() const noexcept
+		{
+			return m_id;
+		}
+
+		void id(Word id) noexcept
+		{
+			m_id = id;
+		}
+
+		// Status passed to SVC exit, if the program has exited.
+		[[nodiscard]]
+		std::optional<Word> exitStatus() const noexcept
+		{
+			return m_exitStatus;
+		}
+
+		// Number of retired instructions.
+		[[nodiscard]]
+		std::uint64_t steps() const noexcept
+		{
+			return m_steps;
+		}
+
+		// Rolls back up to `n` retired instructions recorded by an undo observer such as UndoLog.
+		// Returns the number of instructions undone.
+		std::uint64_t stepBack(std::uint64_t n)
+		{
+			const auto undone = m_observer->undo(*this, n);
+
+			if (undone > 0)
+			{
+				m_steps -= std::min(undone, m_steps);
+				m_exitStatus.reset();
+			}
+
+			return undone;
+		}
+
+		// Clears the registers, the step count and the exit status, so the processor can run again over restored memory.
+		// Streams, logs, channels and the timer settings are kept.
+		void reset() noexcept
+		{
+			m_registers.fill(0);
+			m_exitStatus.reset();
+			m_steps = 0;
+			m_instructionBase = 0;
+			m_cycleBase = 0;
+			m_stepLimit = never;
+			m_inInterrupt = false;
+			m_interruptPending = false;
+			m_waitChannel = nullptr;
+			m_waitSending = false;
+
+			scheduleInterrupt(m_timerPeriod);
+		}
+
+		// Fires the timer interrupt every `period` retired instructions, or disables the timer if `period` is 0.
+		// The handler address is read from `vector`, a word the guest must keep out of its image, frames and stack.
+		void timer(std::uint64_t period, Word vector = interrupts::timerVector) noexcept
+		{
+			m_timerPeriod = period;
+			m_timerVector = vector;
+
+			scheduleInterrupt(period);
+		}
+
+		// Connects a channel to which SVC send on `port` writes.
+		void outbound(Word port, std::shared_ptr<Channel> channel)
+		{
+			connect(m_outbound, port, std::move(channel));
+		}
+
+		// Connects a channel from which SVC receive on `port` reads.
+		void inbound(Word port, std::shared_ptr<Channel> channel)
+		{
+			connect(m_inbound, port, std::move(channel));
+		}
+
+		// Whether the last run() stopped at a send to a full channel or a receive from an empty one.
+		[[nodiscard]]
+		bool parked() const noexcept
+		{
+			return m_waitChannel != nullptr;
+		}
+
+		// Whether the system call the processor is parked at can now proceed.
+		[[nodiscard]]
+		bool ready() const noexcept
+		{
+			return m_waitChannel == nullptr || (m_waitSending ? !m_waitChannel->full() : !m_waitChannel->empty());
+		}
+
+		// Appends every system call and its returned data to the log.
+		void record(std::shared_ptr<SystemCallLog> log) noexcept
+		{
+			m_recordLog = std::move(log);
+		}
+
+		// Serves every system call from the log without host I/O.
+		void replay(std::shared_ptr<SystemCallLog> log) noexcept
+		{
+			m_replayLog = std::move(log);
+		}
+
+		void dumpRegisters(std::ostream& stream)
+		{
+			for (Word i = 0; i < numRegisters; i++)
+			{
+				stream << boost::format("%1$3s = #%2$04X = %2$d") % static_cast<Register>(i) % m_registers[i] << std::endl;
+			}
+		}
+
+	private:
+		[[nodiscard]]
+		constexpr static bool msb(Word value) noexcept
+		{
+			return (value & 0x8000) != 0;
+		}
+
+		[[nodiscard]]
+		constexpr static bool lsb(Word value) noexcept
+		{
+			return (value & 0x0001) != 0;
+		}
+
 		[[nodiscard]]
 		Word stackPointer() const noexcept
 		{
@@ -218,7 +384,7 @@ namespace meteor::runtime
 		void push(Word value) noexcept
 		{
 			stackPointer(stackPointer() - 1);
-			m_memory->write(stackPointer(), value);
+			store(stackPointer(), value);
 		}
 
 		[[nodiscard]]
@@ -230,6 +396,81 @@ namespace meteor::runtime
 			return value;
 		}
 
+		// Only observed processors pay for loading the previous value.
+		void store(Word address, Word value) noexcept
+		{
+			if constexpr (std::is_same_v<Observer, NullObserver>)
+			{
+				m_memory->write(address, value);
+			}
+			else
+			{
+				const auto previous = m_memory->read(address);
+
+				m_memory->write(address, value);
+				m_observer->onMemoryWrite(address, previous, value);
+			}
+		}
+
+		bool execute(Word instruction)
+		{
+			const auto operation = operations::operationCode(instruction);
+			const auto [register1, register2] = operations::registers(instruction);
+
+			switch (operation)
+			{
+				// 0x00 ~ 0x0f
+				case operations::nop      : return executeNOP      ();
+				// 0x10 ~ 0x1f
+				case operations::ld_adr   : return executeLD_adr   (register1, fetchProgram(), register2);
+				case operations::st       : return executeST       (register1, fetchProgram(), register2);
+				case operations::lad      : return executeLAD      (register1, fetchProgram(), register2);
+				case operations::ld_r     : return executeLD_r     (register1, register2);
+				// 0x20 ~ 0x2f
+				case operations::adda_adr : return executeADDA_adr (register1, fetchProgram(), register2);
+				case operations::suba_adr : return executeSUBA_adr (register1, fetchProgram(), register2);
+				case operations::addl_adr : return executeADDL_adr (register1, fetchProgram(), register2);
+				case operations::subl_adr : return executeSUBL_adr (register1, fetchProgram(), register2);
+				case operations::adda_r   : return executeADDA_r   (register1, register2);
+				case operations::suba_r   : return executeSUBA_r   (register1, register2);
+				case operations::addl_r   : return executeADDL_r   (register1, register2);
+				case operations::subl_r   : return executeSUBL_r   (register1, register2);
+				// 0x30 ~ 0x3f
+				case operations::and_adr  : return executeAND_adr  (register1, fetchProgram(), register2);
+				case operations::or_adr   : return executeOR_adr   (register1, fetchProgram(), register2);
+				case operations::xor_adr  : return executeXOR_adr  (register1, fetchProgram(), register2);
+				case operations::and_r    : return executeAND_r    (register1, register2);
+				case operations::or_r     : return executeOR_r     (register1, register2);
+				case operations::xor_r    : return executeXOR_r    (register1, register2);
+				// 0x40 ~ 0x4f
+				case operations::cpa_adr  : return executeCPA_adr  (register1, fetchProgram(), register2);
+				case operations::cpl_adr  : return executeCPL_adr  (register1, fetchProgram(), register2);
+				case operations::cpa_r    : return executeCPA_r    (register1, register2);
+				case operations::cpl_r    : return executeCPL_r    (register1, register2);
+				// 0x50 ~ 0x5f
+				case operations::sla_adr  : return executeSLA_adr  (register1, fetchProgram(), register2);
+				case operations::sra_adr  : return executeSRA_adr  (register1, fetchProgram(), register2);
+				case operations::sll_adr  : return executeSLL_adr  (register1, fetchProgram(), register2);
+				case operations::srl_adr  : return executeSRL_adr  (register1, fetchProgram(), register2);
+				// 0x60 ~ 0x6f
+				case operations::jmi      : return executeJMI      (fetchProgram(), register2);
+				case operations::jnz      : return executeJNZ      (fetchProgram(), register2);
+				case operations::jze      : return executeJZE      (fetchProgram(), register2);
+				case operations::jump     : return executeJUMP     (fetchProgram(), register2);
+				case operations::jpl      : return executeJPL      (fetchProgram(), register2);
+				case operations::jov      : return executeJOV      (fetchProgram(), register2);
+				// 0x70 ~ 0x7f
+				case operations::push     : return executePUSH     (fetchProgram(), register2);
+				case operations::pop      : return executePOP      (register1);
+				// 0x80 ~ 0x8f
+				case operations::call     : return executeCALL     (fetchProgram(), register2);
+				case operations::ret      : return executeRET      ();
+				// 0xf0 ~ 0xff
+				case operations::svc      : return executeSVC      (fetchProgram(), register2);
+				default                   : return executeError    (instruction);
+			}
+		}
+
 		// NOP
 		bool executeNOP()
 		{
@@ -240,7 +481,7 @@ namespace meteor::runtime
 		bool executeLD_adr(Register r, Word adr, Register x)
 		{
 			// r <- m[address]
-			const Word value = m_memory->read(adr + getRegister(x));
+			const Word value = m_memory->read(static_cast<Word>(adr + getRegister(x)));
 
 			setRegister(r, value);
 
@@ -257,7 +498,7 @@ namespace meteor::runtime
 			// address <- r
 			const Word value = getRegister(r);
 
-			m_memory->write(adr + getRegister(x), value);
+			store(adr + getRegister(x), value);
 
 			overflowFlag(false);
 			zeroFlag(value == 0);
@@ -433,7 +674,7 @@ namespace meteor::runtime
 		{
 			// r1 <- r1 & r2
 			const Word left = getRegister(r);
-			const Word right = m_memory->read(adr + getRegister(x));
+			const Word right = m_memory->read(static_cast<Word>(adr + getRegister(x)));
 			const Word value = left & right;
 
 			setRegister(r, value);
@@ -450,7 +691,7 @@ namespace meteor::runtime
 		{
 			// r1 <- r1 | r2
 			const Word left = getRegister(r);
-			const Word right = m_memory->read(adr + getRegister(x));
+			const Word right = m_memory->read(static_cast<Word>(adr + getRegister(x)));
 			const Word value = left | right;
 
 			setRegister(r, value);
@@ -467,7 +708,7 @@ namespace meteor::runtime
 		{
 			// r1 <- r1 ^ r2
 			const Word left = getRegister(r);
-			const Word right = m_memory->read(adr + getRegister(x));
+			const Word right = m_memory->read(static_cast<Word>(adr + getRegister(x)));
 			const Word value = left ^ right;
 
 			setRegister(r, value);
@@ -700,71 +941,52 @@ namespace meteor::runtime
 		bool executeJMI(Word adr, Register x)
 		{
 			// SF == 1
-			if (signFlag())
-			{
-				// pc <- address
-				programCounter(adr + getRegister(x));
-			}
-
-			return true;
+			return jump(signFlag(), adr + getRegister(x));
 		}
 
 		// JNZ adr, x
 		bool executeJNZ(Word adr, Register x)
 		{
 			// ZF == 0
-			if (!zeroFlag())
-			{
-				// pc <- address
-				programCounter(adr + getRegister(x));
-			}
-
-			return true;
+			return jump(!zeroFlag(), adr + getRegister(x));
 		}
 
 		// JZE adr, x
 		bool executeJZE(Word adr, Register x)
 		{
 			// ZF == 1
-			if (zeroFlag())
-			{
-				// pc <- address
-				programCounter(adr + getRegister(x));
-			}
-
-			return true;
+			return jump(zeroFlag(), adr + getRegister(x));
 		}
 
 		// JUMP adr, x
 		bool executeJUMP(Word adr, Register x)
 		{
-			// pc <- address
-			programCounter(adr + getRegister(x));
-
-			return true;
+			return jump(true, adr + getRegister(x));
 		}
 
 		// JPL adr, x
 		bool executeJPL(Word adr, Register x)
 		{
 			// ZF == 0 && SF == 0
-			if (!zeroFlag() && !signFlag())
-			{
-				// pc <- address
-				programCounter(adr + getRegister(x));
-			}
-
-			return true;
+			return jump(!zeroFlag() && !signFlag(), adr + getRegister(x));
 		}
 
 		// JOV adr, x
 		bool executeJOV(Word adr, Register x)
 		{
 			// OF == 1
-			if (overflowFlag())
+			return jump(overflowFlag(), adr + getRegister(x));
+		}
+
+		bool jump(bool condition, Word address)
+		{
+			// Every jump instruction is two words long.
+			m_observer->onBranch(programCounter() - 2, address, condition);
+
+			if (condition)
 			{
 				// pc <- address
-				programCounter(adr + getRegister(x));
+				programCounter(address);
 			}
 
 			return true;
@@ -796,8 +1018,13 @@ namespace meteor::runtime
 			// sp    <- sp - 1
 			// m[sp] <- pc
 			// pc    <- address
+			const Word pc = programCounter() - 2;
+			const Word target = adr + getRegister(x);
+
 			push(programCounter());
-			programCounter(adr + getRegister(x));
+			programCounter(target);
+
+			m_observer->onCall(pc, target);
 
 			return true;
 		}
@@ -810,32 +1037,436 @@ namespace meteor::runtime
 				return false;
 			}
 
-			// r  <- m[sp]
+			// pc <- m[sp]
 			// sp <- sp + 1
+			const Word pc = programCounter() - 1;
+
 			programCounter(pop());
 
+			m_observer->onReturn(pc, programCounter());
+
 			return true;
 		}
 
 		// SVC adr, x
 		bool executeSVC(Word adr, Register x)
 		{
-			switch (adr + getRegister(x))
+			const Word number = adr + getRegister(x);
+
+			// Not inputs of the guest, so never served from the log.
+			switch (number)
+			{
+				case system_calls::returnFromInterrupt:
+					return systemCallReturnFromInterrupt();
+
+				case system_calls::readInstructions:
+					return systemCallReadInstructions();
+
+				case system_calls::readCycles:
+					return systemCallReadCycles();
+
+				case system_calls::resetCounters:
+					return systemCallResetCounters();
+
+				default:
+					break;
+			}
+
+			if constexpr (std::is_same_v<Observer, NullObserver>)
+			{
+				// The step is taken back and the SVC retried by the next run().
+				if (blocked(number))
+				{
+					programCounter(static_cast<Word>(programCounter() - 2));
+					m_steps--;
+					m_stepLimit = m_steps;
+
+					return true;
+				}
+			}
+
+			if (m_replayLog)
+			{
+				return replaySystemCall(number);
+			}
+
+			switch (number)
 			{
 				case system_calls::exit:
-					// Exit system call.
-					std::cout << boost::format("exit status %1$d") % getRegister(Register::general1) << std::endl;
+					return systemCallExit();
 
-					return false;
+				case system_calls::read:
+					return systemCallRead();
+
+				case system_calls::write:
+					return systemCallWrite();
+
+				case system_calls::fetchAdd:
+					return systemCallFetchAdd();
+
+				case system_calls::compareAndSwap:
+					return systemCallCompareAndSwap();
+
+				case system_calls::processorId:
+					return systemCallProcessorId();
+
+				case system_calls::send:
+					return systemCallSend();
+
+				case system_calls::receive:
+					return systemCallReceive();
 
 				default:
 					// Error.
-					std::cerr << boost::format("invalid system call #%1$04X.") % (adr + getRegister(x)) << std::endl;
+					std::cerr << boost::format("invalid system call #%1$04X.") % number << std::endl;
 
 					return false;
 			}
 		}
 
+		bool systemCallExit()
+		{
+			// GR1: exit status
+			const Word status = getRegister(Register::general1);
+
+			recordSystemCall(system_calls::exit, status, 0);
+
+			m_exitStatus = status;
+
+			*m_output << boost::format("exit status %1$d") % status << std::endl;
+
+			return false;
+		}
+
+		bool systemCallRead()
+		{
+			// GR1: buffer, GR2: size
+			const Word buffer = getRegister(Register::general1);
+			const Word size = getRegister(Register::general2);
+
+			Word length = 0;
+
+			while (length < size)
+			{
+				const auto c = m_input->get();
+
+				if (c == std::char_traits<char>::eof())
+				{
+					break;
+				}
+
+				store(static_cast<Word>(buffer + length++), static_cast<Word>(c));
+			}
+
+			recordSystemCall(system_calls::read, length, length);
+
+			setRegister(Register::general1, length);
+
+			return true;
+		}
+
+		bool systemCallWrite()
+		{
+			// GR1: buffer, GR2: size
+			const Word buffer = getRegister(Register::general1);
+			const Word size = getRegister(Register::general2);
+
+			for (Word i = 0; i < size; i++)
+			{
+				m_output->put(static_cast<char>(m_memory->read(static_cast<Word>(buffer + i))));
+			}
+
+			recordSystemCall(system_calls::write, size, 0);
+
+			setRegister(Register::general1, size);
+
+			return true;
+		}
+
+		bool systemCallFetchAdd()
+		{
+			// GR1: address, GR2: addend
+			const Word address = getRegister(Register::general1);
+			const Word addend = getRegister(Register::general2);
+			const Word previous = m_memory->fetchAdd(address, addend);
+
+			m_observer->onMemoryWrite(address, previous, static_cast<Word>(previous + addend));
+
+			recordSystemCall(system_calls::fetchAdd, previous, 1);
+
+			setRegister(Register::general1, previous);
+
+			return true;
+		}
+
+		bool systemCallCompareAndSwap()
+		{
+			// GR1: address, GR2: expected, GR3: desired
+			const Word address = getRegister(Register::general1);
+			const Word expected = getRegister(Register::general2);
+			const Word desired = getRegister(Register::general3);
+			const Word previous = m_memory->compareExchange(address, expected, desired);
+
+			if (previous == expected)
+			{
+				m_observer->onMemoryWrite(address, previous, desired);
+			}
+
+			recordSystemCall(system_calls::compareAndSwap, previous, 1);
+
+			setRegister(Register::general1, previous);
+
+			return true;
+		}
+
+		bool systemCallProcessorId()
+		{
+			recordSystemCall(system_calls::processorId, m_id, 0);
+
+			setRegister(Register::general1, m_id);
+
+			return true;
+		}
+
+		bool systemCallReadInstructions()
+		{
+			// GR1:GR2 <- steps
+			returnCounter(m_steps - std::min(m_instructionBase, m_steps));
+
+			return true;
+		}
+
+		bool systemCallReadCycles()
+		{
+			// GR1:GR2 <- cycles
+			const auto cycles = m_observer->cycleCount(m_steps);
+
+			returnCounter(cycles - std::min(m_cycleBase, cycles));
+
+			return true;
+		}
+
+		bool systemCallResetCounters()
+		{
+			m_instructionBase = m_steps;
+			m_cycleBase = m_observer->cycleCount(m_steps);
+
+			return true;
+		}
+
+		void returnCounter(std::uint64_t value) noexcept
+		{
+			setRegister(Register::general1, static_cast<Word>(value >> 16));
+			setRegister(Register::general2, static_cast<Word>(value));
+		}
+
+		bool systemCallSend()
+		{
+			// GR1: port, GR2: value
+			const auto channel = findChannel(m_outbound, getRegister(Register::general1));
+
+			if (channel == nullptr)
+			{
+				return false;
+			}
+
+			// step() parks before a send to a full channel, and this processor is its only producer.
+			[[maybe_unused]] const auto sent = channel->trySend(getRegister(Register::general2));
+
+			assert(sent);
+
+			recordSystemCall(system_calls::send, 0, 0);
+
+			return true;
+		}
+
+		bool systemCallReceive()
+		{
+			// GR1: port
+			const auto channel = findChannel(m_inbound, getRegister(Register::general1));
+
+			if (channel == nullptr)
+			{
+				return false;
+			}
+
+			// step() parks before a receive from an empty channel, and this processor is its only consumer.
+			Word value = 0;
+
+			[[maybe_unused]] const auto received = channel->tryReceive(value);
+
+			assert(received);
+
+			recordSystemCall(system_calls::receive, value, 0);
+
+			setRegister(Register::general1, value);
+
+			return true;
+		}
+
+		[[nodiscard]]
+		Channel* findChannel(const std::vector<std::shared_ptr<Channel>>& channels, Word port) const
+		{
+			if (port >= channels.size() || !channels[port])
+			{
+				std::cerr << boost::format("port #%1$04X is not connected.") % port << std::endl;
+
+				return nullptr;
+			}
+
+			return channels[port].get();
+		}
+
+		// Number of the system call requested by the SVC at the program counter (already fetched).
+		[[nodiscard]]
+		Word systemCallNumber(Word instruction) const noexcept
+		{
+			const auto x = operations::registers(instruction).second;
+
+			return static_cast<Word>(m_memory->read(programCounter()) + getRegister(x));
+		}
+
+		// Whether system call `number` is a send to a full channel or a receive from an empty one. If so, the
+		// processor parks at it and leaves run(); the SVC is retried by the next run().
+		[[nodiscard]]
+		bool blocked(Word number) noexcept
+		{
+			if (m_replayLog || (m_outbound.empty() && m_inbound.empty()))
+			{
+				return false;
+			}
+
+			const auto port = getRegister(Register::general1);
+
+			const auto sending = number == system_calls::send;
+			const auto& channels = sending ? m_outbound : m_inbound;
+
+			if ((!sending && number != system_calls::receive) || port >= channels.size() || !channels[port])
+			{
+				return false;
+			}
+
+			const auto& channel = *channels[port];
+
+			if (sending ? !channel.full() : !channel.empty())
+			{
+				return false;
+			}
+
+			m_waitChannel = channels[port].get();
+			m_waitSending = sending;
+
+			return true;
+		}
+
+		static void connect(std::vector<std::shared_ptr<Channel>>& channels, Word port, std::shared_ptr<Channel> channel)
+		{
+			if (port >= channels.size())
+			{
+				channels.resize(port + std::size_t {1});
+			}
+
+			channels[port] = std::move(channel);
+		}
+
+		bool systemCallReturnFromInterrupt()
+		{
+			if (!m_inInterrupt)
+			{
+				std::cerr << u8"return from interrupt outside of an interrupt handler." << std::endl;
+
+				return false;
+			}
+
+			// fr <- m[sp], pc <- m[sp + 1]
+			setRegister(Register::flags, pop());
+			programCounter(pop());
+
+			m_inInterrupt = false;
+
+			if (std::exchange(m_interruptPending, false))
+			{
+				// Deliver the interrupt deferred during the handler right away.
+				m_nextInterrupt = m_steps;
+				m_stepLimit = m_steps;
+			}
+
+			return true;
+		}
+
+		void recordSystemCall(Word number, Word result, Word length)
+		{
+			if (!m_recordLog)
+			{
+				return;
+			}
+
+			const Word buffer = getRegister(Register::general1);
+
+			m_recordLog->append(number, buffer, getRegister(Register::general2), result, length, [&](Word i)
+			{
+				return m_memory->read(static_cast<Word>(buffer + i));
+			});
+		}
+
+		bool replaySystemCall(Word number)
+		{
+			const auto entry = m_replayLog->next();
+			const Word argument1 = getRegister(Register::general1);
+			const Word argument2 = getRegister(Register::general2);
+
+			if (entry.number != number || entry.argument1 != argument1 || entry.argument2 != argument2)
+			{
+				throw std::runtime_error {
+					(boost::format(u8"system call log diverged: expected SVC #%1$04X (#%2$04X, #%3$04X), but got SVC #%4$04X (#%5$04X, #%6$04X).")
+						% entry.number % entry.argument1 % entry.argument2 % number % argument1 % argument2).str() };
+			}
+
+			if (number == system_calls::exit)
+			{
+				m_exitStatus = entry.result;
+
+				return false;
+			}
+
+			for (Word i = 0; i < entry.length; i++)
+			{
+				store(static_cast<Word>(argument1 + i), entry.data[i]);
+			}
+
+			setRegister(Register::general1, entry.result);
+
+			return true;
+		}
+
+		void raiseTimerInterrupt()
+		{
+			scheduleInterrupt(m_timerPeriod);
+
+			if (m_inInterrupt)
+			{
+				// Interrupts are masked until the handler returns.
+				m_interruptPending = true;
+
+				return;
+			}
+
+			// sp    <- sp - 1, m[sp] <- pc
+			// sp    <- sp - 1, m[sp] <- fr
+			// pc    <- m[vector]
+			push(programCounter());
+			push(getRegister(Register::flags));
+			programCounter(m_memory->read(m_timerVector));
+
+			m_inInterrupt = true;
+		}
+
+		void scheduleInterrupt(std::uint64_t period) noexcept
+		{
+			m_nextInterrupt = period != 0 && period < never - m_steps ? m_steps + period : never;
+			m_stepLimit = std::min(m_stepLimit, m_nextInterrupt);
+		}
+
 		bool executeError(Word instruction)
 		{
 			std::cerr << boost::format("unknown instruction word #%1$04X.") % instruction << std::endl;
@@ -843,8 +1474,46 @@ namespace meteor::runtime
 			return false;
 		}
 
+		[[nodiscard]]
+		static Observer& nullObserver() noexcept
+		{
+			static_assert(std::is_same_v<Observer, NullObserver>, "an observer must be given.");
+
+			static NullObserver observer;
+
+			return observer;
+		}
+
 		std::shared_ptr<Memory> m_memory;
+		Observer* m_observer;
 
 		std::array<Word, numRegisters> m_registers;
+		Word m_id;
+		std::optional<Word> m_exitStatus;
+
+		std::istream* m_input;
+		std::ostream* m_output;
+
+		std::shared_ptr<SystemCallLog> m_recordLog;
+		std::shared_ptr<SystemCallLog> m_replayLog;
+
+		constexpr static std::uint64_t never = std::numeric_limits<std::uint64_t>::max();
+
+		std::uint64_t m_steps;
+		std::uint64_t m_instructionBase;
+		std::uint64_t m_cycleBase;
+		std::uint64_t m_stepLimit;
+		std::uint64_t m_timerPeriod;
+		Word m_timerVector;
+		std::uint64_t m_nextInterrupt;
+		bool m_inInterrupt;
+		bool m_interruptPending;
+
+		std::vector<std::shared_ptr<Channel>> m_outbound;
+		std::vector<std::shared_ptr<Channel>> m_inbound;
+		Channel* m_waitChannel;
+		bool m_waitSending;
 	};
+
+	using Processor = BasicProcessor<>;
 }
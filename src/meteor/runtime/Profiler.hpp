@@ -0,0 +1,175 @@
+/*================================================================================
+ * The MIT License
+ *
+ * Copyright (c) 2018 Ryooooooga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+================================================================================*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <ostream>
+#include <vector>
+
+#include <boost/format.hpp>
+
+#include "Memory.hpp"
+#include "Observer.hpp"
+#include "../Disassembler.hpp"
+
+namespace meteor::runtime
+{
+	// Counts retired instructions per address, and taken/not-taken jumps per jump instruction.
+	class Profiler
+		: public NullObserver
+	{
+	public:
+		explicit Profiler()
+			: m_counts(addressSpace, 0)
+			, m_taken(addressSpace, 0)
+			, m_notTaken(addressSpace, 0)
+		{
+		}
+
+		// Uncopyable, movable.
+		Profiler(const Profiler&) =delete;
+		Profiler(Profiler&&) =default;
+
+		Profiler& operator=(const Profiler&) =delete;
+		Profiler& operator=(Profiler&&) =default;
+
+		~Profiler() =default;
+
+		template <typename Processor>
+		void onStep([[maybe_unused]] const Processor& processor, Word pc, [[maybe_unused]] Word instruction) noexcept
+		{
+			m_counts[pc]++;
+		}
+
+		void onBranch(Word pc, [[maybe_unused]] Word target, bool taken) noexcept
+		{
+			(taken ? m_taken : m_notTaken)[pc]++;
+		}
+
+		[[nodiscard]]
+		const std::vector<std::uint64_t>& counts() const noexcept
+		{
+			return m_counts;
+		}
+
+		[[nodiscard]]
+		std::uint64_t count(Word pc) const noexcept
+		{
+			return m_counts[pc];
+		}
+
+		[[nodiscard]]
+		std::uint64_t taken(Word pc) const noexcept
+		{
+			return m_taken[pc];
+		}
+
+		[[nodiscard]]
+		std::uint64_t notTaken(Word pc) const noexcept
+		{
+			return m_notTaken[pc];
+		}
+
+		[[nodiscard]]
+		std::uint64_t total() const noexcept
+		{
+			return std::accumulate(std::begin(m_counts), std::end(m_counts), std::uint64_t {0});
+		}
+
+		void reset() noexcept
+		{
+			std::fill(std::begin(m_counts), std::end(m_counts), 0);
+			std::fill(std::begin(m_taken), std::end(m_taken), 0);
+			std::fill(std::begin(m_notTaken), std::end(m_notTaken), 0);
+		}
+
+		// Prints the `top' hottest instructions, followed by the disassembly of every executed instruction.
+		void report(std::ostream& stream, const Memory& memory, std::size_t top = 20) const
+		{
+			const auto sum = std::max(total(), std::uint64_t {1});
+
+			std::vector<Word> executed;
+
+			for (std::size_t pc = 0; pc < addressSpace; pc++)
+			{
+				if (m_counts[pc] > 0)
+				{
+					executed.emplace_back(static_cast<Word>(pc));
+				}
+			}
+
+			auto hottest = executed;
+
+			std::stable_sort(std::begin(hottest), std::end(hottest), [&](Word a, Word b)
+			{
+				return m_counts[a] > m_counts[b];
+			});
+
+			hottest.resize(std::min(top, hottest.size()));
+
+			stream << u8"hot spots:" << std::endl;
+
+			for (const auto pc : hottest)
+			{
+				stream << boost::format(u8"%1$12d %2$6.2f%% ") % m_counts[pc] % (100.0 * m_counts[pc] / sum);
+				printInstruction(stream, memory, pc);
+			}
+
+			stream << std::endl << u8"annotated disassembly:" << std::endl;
+
+			for (const auto pc : executed)
+			{
+				stream << boost::format(u8"%1$12d %2$6.2f%% ") % m_counts[pc] % (100.0 * m_counts[pc] / sum);
+				printInstruction(stream, memory, pc);
+			}
+		}
+
+	private:
+		constexpr static std::size_t addressSpace = 65536;
+
+		void printInstruction(std::ostream& stream, const Memory& memory, Word pc) const
+		{
+			const auto code = memory.read(pc);
+			const auto operand = memory.read(static_cast<Word>(pc + 1));
+
+			if (m_taken[pc] > 0 || m_notTaken[pc] > 0)
+			{
+				stream << boost::format(u8"%1$04X: %2$-24s taken %3%, not taken %4%") % pc % operations::disassemble(code, operand) % m_taken[pc] % m_notTaken[pc];
+			}
+			else
+			{
+				stream << boost::format(u8"%1$04X: %2%") % pc % operations::disassemble(code, operand);
+			}
+
+			stream << std::endl;
+		}
+
+		std::vector<std::uint64_t> m_counts;
+		std::vector<std::uint64_t> m_taken;
+		std::vector<std::uint64_t> m_notTaken;
+	};
+}
@@ -0,0 +1,142 @@
+/*================================================================================
+ * The MIT License
+ *
+ * Copyright (c) 2018 Ryooooooga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+================================================================================*/
+
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "../Operation.hpp"
+#include "../Register.hpp"
+#include "../SystemCall.hpp"
+
+namespace meteor::runtime
+{
+	// Generates images of random instructions for differential testing: every operation with random
+	// registers and operands, jumps and calls to instruction boundaries, the system calls that
+	// neither block nor do I/O, and a final SVC exit. Programs may loop, so run them with a budget.
+	class RandomProgram
+	{
+	public:
+		explicit RandomProgram(std::uint64_t seed)
+			: m_random(seed)
+		{
+		}
+
+		[[nodiscard]]
+		std::vector<Word> generate(std::size_t instructions)
+		{
+			namespace op = operations;
+
+			static constexpr Word operations[] = {
+				op::nop, op::ld_adr, op::st, op::lad, op::ld_r,
+				op::adda_adr, op::suba_adr, op::addl_adr, op::subl_adr, op::adda_r, op::suba_r, op::addl_r, op::subl_r,
+				op::and_adr, op::or_adr, op::xor_adr, op::and_r, op::or_r, op::xor_r,
+				op::cpa_adr, op::cpl_adr, op::cpa_r, op::cpl_r,
+				op::sla_adr, op::sra_adr, op::sll_adr, op::srl_adr,
+				op::jmi, op::jnz, op::jze, op::jump, op::jpl, op::jov,
+				op::push, op::pop,
+				op::call, op::ret,
+				op::svc,
+			};
+
+			static constexpr Word systemCalls[] = {
+				system_calls::fetchAdd,
+				system_calls::compareAndSwap,
+				system_calls::processorId,
+				system_calls::readInstructions,
+				system_calls::readCycles,
+				system_calls::resetCounters,
+			};
+
+			std::vector<Word> image;
+			std::vector<Word> starts;
+			std::vector<std::size_t> branches;
+
+			for (std::size_t i = 0; i < instructions; i++)
+			{
+				const auto operation = operations[uniform(std::size(operations))];
+				const auto code = op::instruction(operation, static_cast<Register>(uniform(8)), static_cast<Register>(uniform(8)));
+
+				starts.emplace_back(static_cast<Word>(image.size()));
+				image.emplace_back(code);
+
+				if (op::length(code) == 1)
+				{
+					continue;
+				}
+
+				switch (operation & 0xf000)
+				{
+					case 0x6000:
+					case 0x8000:
+						// Mostly unindexed, so that control stays on instruction boundaries.
+						if (uniform(4) != 0)
+						{
+							image.back() = op::instruction(operation, Register::general0, Register::general0);
+						}
+
+						branches.emplace_back(image.size());
+						image.emplace_back(0);
+						break;
+
+					case 0x5000:
+						// Shifts take time in proportion to their count.
+						image.emplace_back(static_cast<Word>(uniform(32)));
+						break;
+
+					case 0xf000:
+						image.back() = op::instruction(op::svc, Register::general0, Register::general0);
+						image.emplace_back(systemCalls[uniform(std::size(systemCalls))]);
+						break;
+
+					default:
+						image.emplace_back(static_cast<Word>(uniform(0x10000)));
+						break;
+				}
+			}
+
+			starts.emplace_back(static_cast<Word>(image.size()));
+			image.emplace_back(op::instruction(op::svc, Register::general0, Register::general0));
+			image.emplace_back(system_calls::exit);
+
+			for (const auto i : branches)
+			{
+				image[i] = starts[uniform(starts.size())];
+			}
+
+			return image;
+		}
+
+	private:
+		[[nodiscard]]
+		std::size_t uniform(std::size_t n)
+		{
+			return std::uniform_int_distribution<std::size_t> { 0, n - 1 }(m_random);
+		}
+
+		std::mt19937_64 m_random;
+	};
+}
@@ -0,0 +1,252 @@
+/*================================================================================
+ * The MIT License
+ *
+ * Copyright (c) 2018 Ryooooooga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+================================================================================*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <boost/format.hpp>
+
+#include "Memory.hpp"
+#include "../Operation.hpp"
+#include "../Register.hpp"
+#include "../SymbolMap.hpp"
+
+namespace meteor::runtime
+{
+	// Samples PC, SP and the top words of the stack about every `interval' retired instructions.
+	// The profiler is not an observer: run() drives the processor in slices that end at the next sample, so the
+	// instructions in between run at full speed and sampling costs one run() call per interval.
+	// Intervals are drawn uniformly from [interval / 2, interval * 3 / 2] so that samples do not alias with loops.
+	// Once the buffer is full, reservoir sampling keeps a uniform selection over the whole run.
+	class SamplingProfiler
+	{
+	public:
+		constexpr static std::size_t stackDepth = 4;
+
+		struct Sample
+		{
+			Word pc;
+			Word sp;
+			std::array<Word, stackDepth> stack; // m[sp], m[sp + 1], ...
+		};
+
+		explicit SamplingProfiler(std::uint64_t interval = 1000, std::size_t capacity = 65536, std::uint64_t seed = 0x9e3779b97f4a7c15)
+			: m_interval(std::max(interval, std::uint64_t {1}))
+			, m_capacity(std::max(capacity, std::size_t {1}))
+			, m_samples()
+			, m_taken(0)
+			, m_random(seed | 1)
+			, m_countdown(0)
+		{
+			m_samples.reserve(m_capacity);
+			m_countdown = nextInterval();
+		}
+
+		// Uncopyable, movable.
+		SamplingProfiler(const SamplingProfiler&) =delete;
+		SamplingProfiler(SamplingProfiler&&) =default;
+
+		SamplingProfiler& operator=(const SamplingProfiler&) =delete;
+		SamplingProfiler& operator=(SamplingProfiler&&) =default;
+
+		~SamplingProfiler() =default;
+
+		// Runs the processor for at most `budget` instructions, sampling it between slices.
+		// Returns false when the program has stopped, like Processor::run.
+		template <typename Processor>
+		bool run(Processor& processor, std::uint64_t budget)
+		{
+			while (budget > 0)
+			{
+				const auto slice = std::min(m_countdown, budget);
+				const auto steps = processor.steps();
+
+				if (!processor.run(slice))
+				{
+					return false;
+				}
+
+				const auto done = processor.steps() - steps;
+
+				budget -= done;
+				m_countdown -= done;
+
+				if (m_countdown == 0)
+				{
+					sample(processor);
+				}
+
+				// Parked at a send or receive; the caller resumes it once the channel is ready.
+				if (done < slice)
+				{
+					return true;
+				}
+			}
+
+			return true;
+		}
+
+		[[nodiscard]]
+		const std::vector<Sample>& samples() const noexcept
+		{
+			return m_samples;
+		}
+
+		// Number of samples taken, including those the buffer no longer holds.
+		[[nodiscard]]
+		std::uint64_t taken() const noexcept
+		{
+			return m_taken;
+		}
+
+		// Samples per function of the sampled PC, sorted by count.
+		void report(std::ostream& stream, const SymbolMap& symbolMap) const
+		{
+			std::map<std::string, std::uint64_t> counts;
+
+			for (const auto& s : m_samples)
+			{
+				counts[name(symbolMap, s.pc)]++;
+			}
+
+			std::vector<std::pair<std::string, std::uint64_t>> sorted { std::begin(counts), std::end(counts) };
+
+			std::stable_sort(std::begin(sorted), std::end(sorted), [](const auto& a, const auto& b)
+			{
+				return a.second > b.second;
+			});
+
+			const auto sum = std::max(m_samples.size(), std::size_t {1});
+
+			stream << boost::format(u8"samples: %1% of %2% taken") % m_samples.size() % m_taken << std::endl;
+
+			for (const auto& [function, count] : sorted)
+			{
+				stream << boost::format(u8"%1$-24s %2$10d %3$6.2f%%") % function % count % (100.0 * count / sum) << std::endl;
+			}
+		}
+
+		// Writes `caller;callee count' lines for flamegraph.pl. Callers are the stack words that
+		// look like return addresses, i.e. follow a CALL instruction in the program.
+		void writeCollapsedStacks(std::ostream& stream, const SymbolMap& symbolMap, const Memory& memory) const
+		{
+			std::map<std::string, std::uint64_t> stacks;
+
+			for (const auto& s : m_samples)
+			{
+				std::string stack = name(symbolMap, s.pc);
+
+				for (const auto word : s.stack)
+				{
+					if (isReturnAddress(symbolMap, memory, word))
+					{
+						stack = name(symbolMap, word) + u8";" + stack;
+					}
+				}
+
+				stacks[stack]++;
+			}
+
+			for (const auto& [stack, count] : stacks)
+			{
+				stream << stack << u8" " << count << std::endl;
+			}
+		}
+
+	private:
+		// Samples the instruction about to execute.
+		template <typename Processor>
+		void sample(const Processor& processor)
+		{
+			const auto memory = processor.memory();
+			const auto sp = processor.getRegister(Register::stackPointer);
+
+			auto s = Sample { processor.getRegister(Register::programCounter), sp, {} };
+
+			for (std::size_t i = 0; i < stackDepth; i++)
+			{
+				s.stack[i] = memory->read(static_cast<Word>(sp + i));
+			}
+
+			if (m_samples.size() < m_capacity)
+			{
+				m_samples.emplace_back(s);
+			}
+			else if (const auto j = random() % (m_taken + 1); j < m_capacity)
+			{
+				m_samples[j] = s;
+			}
+
+			m_taken++;
+			m_countdown = nextInterval();
+		}
+
+		[[nodiscard]]
+		std::uint64_t nextInterval() noexcept
+		{
+			return std::max(m_interval / 2 + random() % (m_interval + 1), std::uint64_t {1});
+		}
+
+		// xorshift64
+		[[nodiscard]]
+		std::uint64_t random() noexcept
+		{
+			m_random ^= m_random << 13;
+			m_random ^= m_random >> 7;
+			m_random ^= m_random << 17;
+
+			return m_random;
+		}
+
+		[[nodiscard]]
+		static std::string name(const SymbolMap& symbolMap, Word address)
+		{
+			const auto f = symbolMap.find(address);
+
+			return f == SymbolMap::npos ? std::string { u8"[unknown]" } : symbolMap.functions()[f].name;
+		}
+
+		[[nodiscard]]
+		static bool isReturnAddress(const SymbolMap& symbolMap, const Memory& memory, Word word)
+		{
+			return word >= 2
+				&& symbolMap.find(word) != SymbolMap::npos
+				&& operations::operationCode(memory.read(static_cast<Word>(word - 2))) == operations::call;
+		}
+
+		std::uint64_t m_interval;
+		std::size_t m_capacity;
+		std::vector<Sample> m_samples;
+		std::uint64_t m_taken;
+		std::uint64_t m_random;
+		std::uint64_t m_countdown;
+	};
+}
@@ -0,0 +1,285 @@
+/*================================================================================
+ * The MIT License
+ *
+ * Copyright (c) 2018 Ryooooooga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+================================================================================*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <vector>
+
+#include <boost/format.hpp>
+
+#include "Observer.hpp"
+#include "../Operation.hpp"
+#include "../Register.hpp"
+#include "../SymbolMap.hpp"
+
+namespace meteor::runtime
+{
+	// High-water marks of the two stacks of compiled code, per function and per run: the hardware stack
+	// of PUSH and CALL growing down from #FFFF, and the GR7 frames growing up from the end of the image.
+	// Functions are delimited by CALL and RET; marks are exclusive of callees.
+	class StackProfiler
+		: public NullObserver
+	{
+	public:
+		struct Function
+		{
+			std::uint64_t calls;
+			// Deepest simultaneous activations, to spot runaway recursion.
+			std::uint64_t recursion;
+			// Lowest SP while the function was running; 0 if it never pushed.
+			Word minimumStackPointer;
+			// Words above GR7 on entry used by the frame: its own GR7 bumps and the frame words it wrote,
+			// which include the arguments it passes.
+			Word frameWords;
+		};
+
+		explicit StackProfiler(SymbolMap symbolMap, Word entry = 0x0000)
+			: m_symbolMap(std::move(symbolMap))
+			, m_functions(m_symbolMap.functions().size() + 1, Function { 0, 0, 0, 0 })
+			, m_active(m_functions.size(), 0)
+			, m_frames()
+			, m_stackPointer(0)
+			, m_framePointer(0)
+			, m_frameBase()
+			, m_minimumStackPointer(0)
+			, m_frameTop(0)
+			, m_minimumGap(0x10000)
+			, m_collision()
+			, m_steps(0)
+			, m_pushing(false)
+		{
+			enter(entry);
+		}
+
+		// Uncopyable, movable.
+		StackProfiler(const StackProfiler&) =delete;
+		StackProfiler(StackProfiler&&) =default;
+
+		StackProfiler& operator=(const StackProfiler&) =delete;
+		StackProfiler& operator=(StackProfiler&&) =default;
+
+		~StackProfiler() =default;
+
+		template <typename Processor>
+		void onStep(const Processor& processor, [[maybe_unused]] Word pc, Word instruction) noexcept
+		{
+			const auto operation = operations::operationCode(instruction);
+
+			// Their writes belong to the hardware stack.
+			m_pushing = operation == operations::push || operation == operations::call;
+			m_steps = processor.steps();
+		}
+
+		template <typename Processor>
+		void onRetire(const Processor& processor) noexcept
+		{
+			m_stackPointer = processor.getRegister(Register::stackPointer);
+			m_framePointer = processor.getRegister(Register::general7);
+
+			auto& frame = m_frames.back();
+			auto& function = m_functions[frame.function];
+
+			if (m_stackPointer != 0)
+			{
+				m_minimumStackPointer = m_minimumStackPointer == 0 ? m_stackPointer : std::min(m_minimumStackPointer, m_stackPointer);
+				function.minimumStackPointer = function.minimumStackPointer == 0 ? m_stackPointer : std::min(function.minimumStackPointer, m_stackPointer);
+			}
+
+			if (m_frameBase && m_framePointer >= frame.framePointer)
+			{
+				function.frameWords = std::max(function.frameWords, static_cast<Word>(m_framePointer - frame.framePointer));
+				m_frameTop = std::max(m_frameTop, m_framePointer);
+			}
+
+			if (m_frameBase)
+			{
+				const std::uint32_t stackBottom = m_stackPointer == 0 ? 0x10000 : m_stackPointer;
+				const auto gap = stackBottom > m_frameTop ? stackBottom - m_frameTop : 0;
+
+				m_minimumGap = std::min(m_minimumGap, gap);
+
+				if (gap == 0 && !m_collision)
+				{
+					m_collision = m_steps;
+				}
+			}
+		}
+
+		void onMemoryWrite(Word address, [[maybe_unused]] Word previous, [[maybe_unused]] Word value) noexcept
+		{
+			const auto& frame = m_frames.back();
+
+			if (m_pushing || !m_frameBase || address < frame.framePointer || (m_stackPointer != 0 && address >= m_stackPointer))
+			{
+				return;
+			}
+
+			auto& function = m_functions[frame.function];
+
+			function.frameWords = std::max(function.frameWords, static_cast<Word>(address + 1 - frame.framePointer));
+			m_frameTop = std::max(m_frameTop, static_cast<Word>(address + 1));
+		}
+
+		void onCall([[maybe_unused]] Word pc, Word target)
+		{
+			if (!m_frameBase)
+			{
+				// The startup code sets GR7 to the end of the image before calling main.
+				m_frameBase = m_framePointer;
+				m_frameTop = m_framePointer;
+				m_frames.front().framePointer = m_framePointer;
+			}
+
+			enter(target);
+		}
+
+		void onReturn([[maybe_unused]] Word pc, [[maybe_unused]] Word target) noexcept
+		{
+			if (m_frames.size() > 1)
+			{
+				m_active[m_frames.back().function]--;
+				m_frames.pop_back();
+			}
+		}
+
+		[[nodiscard]]
+		const Function& function(std::size_t index) const noexcept
+		{
+			return m_functions[index];
+		}
+
+		// Words used by the hardware stack at its deepest.
+		[[nodiscard]]
+		std::uint32_t stackWords() const noexcept
+		{
+			return m_minimumStackPointer == 0 ? 0 : 0x10000 - m_minimumStackPointer;
+		}
+
+		// Words used by the frames at their highest.
+		[[nodiscard]]
+		Word frameWords() const noexcept
+		{
+			return m_frameBase ? static_cast<Word>(m_frameTop - *m_frameBase) : 0;
+		}
+
+		// Smallest distance between the two stacks.
+		[[nodiscard]]
+		std::uint32_t minimumGap() const noexcept
+		{
+			return m_minimumGap;
+		}
+
+		// First step at which the frames reached the hardware stack.
+		[[nodiscard]]
+		std::optional<std::uint64_t> collision() const noexcept
+		{
+			return m_collision;
+		}
+
+		void report(std::ostream& stream) const
+		{
+			stream
+				<< boost::format(u8"hardware stack: %1% words (lowest SP #%2$04X)") % stackWords() % m_minimumStackPointer << std::endl
+				<< boost::format(u8"frames: %1% words (#%2$04X to #%3$04X)") % frameWords() % m_frameBase.value_or(0) % m_frameTop << std::endl
+				<< boost::format(u8"headroom: %1% words at the closest") % m_minimumGap << std::endl;
+
+			if (m_collision)
+			{
+				stream << boost::format(u8"the stacks collided at step %1%") % *m_collision << std::endl;
+			}
+
+			std::vector<std::size_t> order;
+
+			for (std::size_t f = 0; f < m_functions.size(); f++)
+			{
+				if (m_functions[f].calls > 0)
+				{
+					order.emplace_back(f);
+				}
+			}
+
+			std::sort(std::begin(order), std::end(order), [&](std::size_t a, std::size_t b)
+			{
+				return depth(m_functions[a]) + m_functions[a].frameWords > depth(m_functions[b]) + m_functions[b].frameWords;
+			});
+
+			stream << std::endl << boost::format(u8"%1$-24s %2$10s %3$10s %4$10s %5$10s") % u8"function" % u8"calls" % u8"recursion" % u8"stack" % u8"frame" << std::endl;
+
+			for (const auto f : order)
+			{
+				const auto& function = m_functions[f];
+
+				stream
+					<< boost::format(u8"%1$-24s %2$10d %3$10d %4$10d %5$10d")
+						% (f < m_symbolMap.functions().size() ? m_symbolMap.functions()[f].name : std::string { u8"[unknown]" })
+						% function.calls
+						% function.recursion
+						% depth(function)
+						% function.frameWords
+					<< std::endl;
+			}
+		}
+
+	private:
+		struct Frame
+		{
+			std::size_t function;
+			Word framePointer;
+		};
+
+		[[nodiscard]]
+		static std::uint32_t depth(const Function& function) noexcept
+		{
+			return function.minimumStackPointer == 0 ? 0 : 0x10000 - function.minimumStackPointer;
+		}
+
+		void enter(Word target)
+		{
+			const auto found = m_symbolMap.find(target);
+			const auto f = found == SymbolMap::npos ? m_functions.size() - 1 : found;
+
+			m_functions[f].calls++;
+			m_functions[f].recursion = std::max(m_functions[f].recursion, ++m_active[f]);
+			m_frames.emplace_back(Frame { f, m_framePointer });
+		}
+
+		SymbolMap m_symbolMap;
+		std::vector<Function> m_functions;
+		std::vector<std::uint64_t> m_active;
+		std::vector<Frame> m_frames;
+		Word m_stackPointer;
+		Word m_framePointer;
+		std::optional<Word> m_frameBase;
+		Word m_minimumStackPointer;
+		Word m_frameTop;
+		std::uint32_t m_minimumGap;
+		std::optional<std::uint64_t> m_collision;
+		std::uint64_t m_steps;
+		bool m_pushing;
+	};
+}
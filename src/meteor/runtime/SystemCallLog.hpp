@@ -0,0 +1,199 @@
+/*================================================================================
+ * The MIT License
+ *
+ * Copyright (c) 2018 Ryooooooga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+================================================================================*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+#include "../Type.hpp"
+
+namespace meteor::runtime
+{
+	// Log of system calls, used to record and replay the nondeterministic inputs of a guest.
+	//
+	// Each entry is a sequence of words:
+	//     number, GR1, GR2, result, length, data[length]
+	class SystemCallLog
+	{
+	public:
+		struct Entry
+		{
+			Word number;
+			Word argument1;
+			Word argument2;
+			Word result;
+			const Word* data;
+			Word length;
+		};
+
+		explicit SystemCallLog()
+			: m_words()
+			, m_position(0)
+		{
+		}
+
+		// Uncopyable, movable.
+		SystemCallLog(const SystemCallLog&) =delete;
+		SystemCallLog(SystemCallLog&&) =default;
+
+		SystemCallLog& operator=(const SystemCallLog&) =delete;
+		SystemCallLog& operator=(SystemCallLog&&) =default;
+
+		~SystemCallLog() =default;
+
+		[[nodiscard]]
+		static SystemCallLog load(std::istream& stream)
+		{
+			char magic[sizeof(signature)] {};
+
+			stream.read(magic, sizeof(magic));
+
+			if (!stream || !std::equal(std::begin(magic), std::end(magic), std::begin(signature)))
+			{
+				throw std::runtime_error { u8"invalid system call log." };
+			}
+
+			SystemCallLog log {};
+
+			// The count is not trusted: words are read one by one, so a corrupt count fails at the
+			// end of the stream instead of allocating the memory it claims.
+			const auto size = readInteger(stream, 8);
+
+			log.m_words.reserve(static_cast<std::size_t>(std::min<std::uint64_t>(size, 1 << 20)));
+
+			for (std::uint64_t i = 0; i < size; i++)
+			{
+				log.m_words.emplace_back(static_cast<Word>(readInteger(stream, 2)));
+			}
+
+			return log;
+		}
+
+		void save(std::ostream& stream) const
+		{
+			stream.write(signature, sizeof(signature));
+
+			writeInteger(stream, m_words.size(), 8);
+
+			for (const auto word : m_words)
+			{
+				writeInteger(stream, word, 2);
+			}
+		}
+
+		[[nodiscard]]
+		std::size_t size() const noexcept
+		{
+			return m_words.size();
+		}
+
+		[[nodiscard]]
+		bool eof() const noexcept
+		{
+			return m_position >= m_words.size();
+		}
+
+		void rewind() noexcept
+		{
+			m_position = 0;
+		}
+
+		template <typename ReadData>
+		void append(Word number, Word argument1, Word argument2, Word result, Word length, ReadData&& readData)
+		{
+			m_words.insert(std::end(m_words), { number, argument1, argument2, result, length });
+
+			for (Word i = 0; i < length; i++)
+			{
+				m_words.emplace_back(readData(i));
+			}
+		}
+
+		[[nodiscard]]
+		Entry next()
+		{
+			constexpr std::size_t headerSize = 5;
+
+			if (m_position + headerSize > m_words.size())
+			{
+				throw std::runtime_error { u8"system call log exhausted." };
+			}
+
+			const auto header = &m_words[m_position];
+			const Word length = header[4];
+
+			if (m_position + headerSize + length > m_words.size())
+			{
+				throw std::runtime_error { u8"truncated system call log." };
+			}
+
+			m_position += headerSize + length;
+
+			return Entry { header[0], header[1], header[2], header[3], header + headerSize, length };
+		}
+
+	private:
+		constexpr static char signature[8] = { 'M', 'E', 'T', 'E', 'O', 'R', 'S', 'C' };
+
+		[[nodiscard]]
+		static std::uint64_t readInteger(std::istream& stream, std::size_t bytes)
+		{
+			unsigned char buffer[8] {};
+
+			if (!stream.read(reinterpret_cast<char*>(buffer), bytes))
+			{
+				throw std::runtime_error { u8"truncated system call log." };
+			}
+
+			std::uint64_t value = 0;
+
+			for (std::size_t i = 0; i < bytes; i++)
+			{
+				value |= std::uint64_t {buffer[i]} << (8 * i);
+			}
+
+			return value;
+		}
+
+		static void writeInteger(std::ostream& stream, std::uint64_t value, std::size_t bytes)
+		{
+			char buffer[8] {};
+
+			for (std::size_t i = 0; i < bytes; i++)
+			{
+				buffer[i] = static_cast<char>(value >> (8 * i));
+			}
+
+			stream.write(buffer, bytes);
+		}
+
+		std::vector<Word> m_words;
+		std::size_t m_position;
+	};
+}
@@ -0,0 +1,117 @@
+/*================================================================================
+ * The MIT License
+ *
+ * Copyright (c) 2018 Ryooooooga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+================================================================================*/
+
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "Observer.hpp"
+#include "../SymbolMap.hpp"
+#include "../Tracer.hpp"
+
+namespace meteor::runtime
+{
+	// Records guest function activations as trace events, timed in processor steps.
+	class TraceObserver
+		: public NullObserver
+	{
+	public:
+		explicit TraceObserver(Tracer& tracer, SymbolMap symbolMap, Word entry = 0x0000)
+			: m_tracer(&tracer)
+			, m_symbolMap(std::move(symbolMap))
+			, m_frames()
+			, m_now(0)
+		{
+			m_frames.emplace_back(Frame { name(entry), 0 });
+		}
+
+		// Uncopyable, movable.
+		TraceObserver(const TraceObserver&) =delete;
+		TraceObserver(TraceObserver&&) =default;
+
+		TraceObserver& operator=(const TraceObserver&) =delete;
+		TraceObserver& operator=(TraceObserver&&) =default;
+
+		// The tracer refers to the function names, so they must stay alive until it is written.
+		~TraceObserver() =default;
+
+		template <typename Processor>
+		void onStep(const Processor& processor, [[maybe_unused]] Word pc, [[maybe_unused]] Word instruction) noexcept
+		{
+			m_now = processor.steps();
+		}
+
+		void onCall([[maybe_unused]] Word pc, Word target)
+		{
+			m_frames.emplace_back(Frame { name(target), m_now });
+		}
+
+		void onReturn([[maybe_unused]] Word pc, [[maybe_unused]] Word target)
+		{
+			if (m_frames.size() > 1)
+			{
+				close();
+			}
+		}
+
+		// Closes the frames still active when the processor stopped.
+		void finish()
+		{
+			while (!m_frames.empty())
+			{
+				close();
+			}
+		}
+
+	private:
+		struct Frame
+		{
+			std::string_view name;
+			std::uint64_t start;
+		};
+
+		[[nodiscard]]
+		std::string_view name(Word address) const noexcept
+		{
+			const auto f = m_symbolMap.find(address);
+
+			return f == SymbolMap::npos ? std::string_view { u8"?" } : std::string_view { m_symbolMap.functions()[f].name };
+		}
+
+		void close()
+		{
+			const auto& frame = m_frames.back();
+
+			m_tracer->add(Tracer::Event { frame.name, u8"guest", frame.start, m_now + 1 - frame.start, Tracer::Clock::guest });
+			m_frames.pop_back();
+		}
+
+		Tracer* m_tracer;
+		SymbolMap m_symbolMap;
+		std::vector<Frame> m_frames;
+		std::uint64_t m_now;
+	};
+}
@@ -0,0 +1,328 @@
+/*================================================================================
+ * The MIT License
+ *
+ * Copyright (c) 2018 Ryooooooga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+================================================================================*/
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "Observer.hpp"
+#include "../Register.hpp"
+
+namespace meteor::runtime
+{
+	// Records the values each retired instruction overwrote in a ring buffer, so that
+	// BasicProcessor::stepBack() can roll the machine back. The oldest records are dropped when it is full.
+	//
+	// A record is a header, the previous memory words (address, value), the previous registers and the header again;
+	// the leading header lets the oldest record be dropped, the trailing one lets the newest be undone.
+	// The header holds the changed registers in bits 0-9 (GR0-GR7, SP, FR), how PC moved in bits 10-11
+	// (1 or 2: advanced by that many words, 0: the previous PC follows the registers) and the number of
+	// memory writes in bits 12-15 (15: a 32-bit count follows the leading and precedes the trailing header).
+	// Instructions that only advance PC and set one register take 6 bytes.
+	//
+	// Output, channel traffic and the timer state are not rolled back.
+	class UndoLog
+		: public NullObserver
+	{
+	public:
+		explicit UndoLog(std::size_t capacity = 1 << 20)
+			: m_ring(roundUp(capacity), 0)
+			, m_mask(m_ring.size() - 1)
+			, m_head(0)
+			, m_tail(0)
+			, m_records(0)
+			, m_primed(false)
+			, m_registers()
+			, m_writes()
+			, m_record()
+		{
+			m_writes.reserve(64);
+			m_record.reserve(64);
+		}
+
+		// Uncopyable, movable.
+		UndoLog(const UndoLog&) =delete;
+		UndoLog(UndoLog&&) =default;
+
+		UndoLog& operator=(const UndoLog&) =delete;
+		UndoLog& operator=(UndoLog&&) =default;
+
+		~UndoLog() =default;
+
+		template <typename Processor>
+		void onStep(const Processor& processor, Word pc, [[maybe_unused]] Word instruction) noexcept
+		{
+			if (!m_primed)
+			{
+				snapshot(processor);
+				m_registers[programCounter] = pc;
+				m_primed = true;
+			}
+		}
+
+		void onMemoryWrite(Word address, Word previous, [[maybe_unused]] Word value)
+		{
+			m_writes.emplace_back(address, previous);
+		}
+
+		// Compares against the registers after the previous instruction, so changes made by
+		// an interrupt in between are undone together with the next instruction.
+		template <typename Processor>
+		void onRetire(const Processor& processor)
+		{
+			std::uint16_t header = 0;
+
+			m_record.clear();
+			m_record.resize(2);
+
+			const auto writes = m_writes.size();
+
+			if (writes < manyWrites)
+			{
+				header |= static_cast<std::uint16_t>(writes << 12);
+			}
+			else
+			{
+				header |= static_cast<std::uint16_t>(manyWrites << 12);
+				writeCount(writes);
+			}
+
+			for (const auto& [address, previous] : m_writes)
+			{
+				writeWord(address);
+				writeWord(previous);
+			}
+
+			m_writes.clear();
+
+			for (std::size_t i = 0; i < trackedRegisters; i++)
+			{
+				const auto value = processor.getRegister(trackedRegister(i));
+
+				if (value != m_registers[i])
+				{
+					header |= static_cast<std::uint16_t>(1 << i);
+					writeWord(m_registers[i]);
+					m_registers[i] = value;
+				}
+			}
+
+			const auto pc = processor.getRegister(Register::programCounter);
+			const auto advance = static_cast<Word>(pc - m_registers[programCounter]);
+
+			if (advance == 1 || advance == 2)
+			{
+				header |= static_cast<std::uint16_t>(advance << 10);
+			}
+			else
+			{
+				writeWord(m_registers[programCounter]);
+			}
+
+			m_registers[programCounter] = pc;
+
+			if (writes >= manyWrites)
+			{
+				writeCount(writes);
+			}
+
+			writeWord(header);
+			m_record[0] = static_cast<unsigned char>(header);
+			m_record[1] = static_cast<unsigned char>(header >> 8);
+
+			append();
+		}
+
+		// Rolls the processor back by up to `n` instructions; returns how many were undone.
+		template <typename Processor>
+		std::uint64_t undo(Processor& processor, std::uint64_t n)
+		{
+			const auto memory = processor.memory();
+
+			std::uint64_t undone = 0;
+
+			for (; undone < n && m_records > 0; undone++)
+			{
+				auto position = m_head - 2;
+				const auto header = readWord(position);
+				const auto writes = (header >> 12) == manyWrites ? readCount(position -= 4) : static_cast<std::size_t>(header >> 12);
+
+				if (((header >> 10) & 0b11) == 0)
+				{
+					processor.setRegister(Register::programCounter, readWord(position -= 2));
+				}
+				else
+				{
+					processor.setRegister(Register::programCounter, static_cast<Word>(processor.getRegister(Register::programCounter) - ((header >> 10) & 0b11)));
+				}
+
+				for (auto i = trackedRegisters; i-- > 0; )
+				{
+					if (header & (1 << i))
+					{
+						processor.setRegister(trackedRegister(i), readWord(position -= 2));
+					}
+				}
+
+				for (std::size_t i = 0; i < writes; i++)
+				{
+					const auto previous = readWord(position -= 2);
+
+					memory->write(readWord(position -= 2), previous);
+				}
+
+				m_head = position - ((header >> 12) == manyWrites ? 6 : 2);
+				m_records--;
+			}
+
+			snapshot(processor);
+
+			return undone;
+		}
+
+		// Number of instructions that can be undone.
+		[[nodiscard]]
+		std::uint64_t records() const noexcept
+		{
+			return m_records;
+		}
+
+	private:
+		constexpr static std::size_t trackedRegisters = 10;
+		constexpr static std::size_t programCounter = trackedRegisters;
+		constexpr static std::size_t manyWrites = 15;
+
+		[[nodiscard]]
+		constexpr static Register trackedRegister(std::size_t index) noexcept
+		{
+			return static_cast<Register>(index < 9 ? index : 10);
+		}
+
+		[[nodiscard]]
+		static std::size_t roundUp(std::size_t capacity) noexcept
+		{
+			std::size_t size = 64;
+
+			while (size < capacity)
+			{
+				size <<= 1;
+			}
+
+			return size;
+		}
+
+		template <typename Processor>
+		void snapshot(const Processor& processor) noexcept
+		{
+			for (std::size_t i = 0; i < trackedRegisters; i++)
+			{
+				m_registers[i] = processor.getRegister(trackedRegister(i));
+			}
+
+			m_registers[programCounter] = processor.getRegister(Register::programCounter);
+		}
+
+		void writeWord(Word word)
+		{
+			m_record.emplace_back(static_cast<unsigned char>(word));
+			m_record.emplace_back(static_cast<unsigned char>(word >> 8));
+		}
+
+		void writeCount(std::size_t count)
+		{
+			writeWord(static_cast<Word>(count));
+			writeWord(static_cast<Word>(count >> 16));
+		}
+
+		[[nodiscard]]
+		Word readWord(std::uint64_t position) const noexcept
+		{
+			return static_cast<Word>(m_ring[position & m_mask] | (m_ring[(position + 1) & m_mask] << 8));
+		}
+
+		[[nodiscard]]
+		std::size_t readCount(std::uint64_t position) const noexcept
+		{
+			return readWord(position) | (static_cast<std::size_t>(readWord(position + 2)) << 16);
+		}
+
+		// Size of the record starting at `position', from its leading header.
+		[[nodiscard]]
+		std::size_t recordSize(std::uint64_t position) const noexcept
+		{
+			const auto header = readWord(position);
+			const auto many = (header >> 12) == manyWrites;
+			const auto writes = many ? readCount(position + 2) : static_cast<std::size_t>(header >> 12);
+
+			std::size_t registers = 0;
+
+			for (std::size_t i = 0; i < trackedRegisters; i++)
+			{
+				registers += (header >> i) & 1;
+			}
+
+			registers += ((header >> 10) & 0b11) == 0;
+
+			return 4 + (many ? 8 : 0) + writes * 4 + registers * 2;
+		}
+
+		void append()
+		{
+			if (m_record.size() > m_ring.size())
+			{
+				// Too large to keep; nothing before it can be undone either.
+				m_tail = m_head;
+				m_records = 0;
+
+				return;
+			}
+
+			while (m_head + m_record.size() - m_tail > m_ring.size())
+			{
+				m_tail += recordSize(m_tail);
+				m_records--;
+			}
+
+			for (const auto byte : m_record)
+			{
+				m_ring[m_head++ & m_mask] = byte;
+			}
+
+			m_records++;
+		}
+
+		std::vector<unsigned char> m_ring;
+		std::size_t m_mask;
+		std::uint64_t m_head;
+		std::uint64_t m_tail;
+		std::uint64_t m_records;
+		bool m_primed;
+		std::array<Word, trackedRegisters + 1> m_registers;
+		std::vector<std::pair<Word, Word>> m_writes;
+		std::vector<unsigned char> m_record;
+	};
+}
@@ -0,0 +1,160 @@
+/*================================================================================
+ * The MIT License
+ *
+ * Copyright (c) 2018 Ryooooooga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+================================================================================*/
+
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace meteor::server
+{
+	// Thread-safe memo table keyed by content.
+	// Entries are found by the hash of the content and confirmed by comparing the content itself.
+	// The oldest entries are evicted once the contents and values together exceed `capacity` bytes.
+	template <typename Value>
+	class ContentCache
+	{
+	public:
+		explicit ContentCache(std::size_t capacity)
+			: m_capacity(capacity)
+			, m_size(0)
+			, m_mutex()
+			, m_table()
+			, m_order()
+		{
+		}
+
+		// Uncopyable, unmovable.
+		ContentCache(const ContentCache&) =delete;
+		ContentCache(ContentCache&&) =delete;
+
+		ContentCache& operator=(const ContentCache&) =delete;
+		ContentCache& operator=(ContentCache&&) =delete;
+
+		~ContentCache() =default;
+
+		[[nodiscard]]
+		std::shared_ptr<const Value> find(const std::string& content) const
+		{
+			const auto hash = std::hash<std::string> {}(content);
+
+			std::shared_lock lock { m_mutex };
+
+			if (const auto it = lookup(hash, content); it != std::end(m_table))
+			{
+				return it->second.value;
+			}
+
+			return nullptr;
+		}
+
+		// `size` is the number of bytes held by the value. Content already cached is left as is,
+		// and an entry larger than the capacity is not cached at all.
+		void insert(const std::string& content, std::shared_ptr<const Value> value, std::size_t size)
+		{
+			const auto hash = std::hash<std::string> {}(content);
+			const auto bytes = content.size() + size;
+
+			if (bytes > m_capacity)
+			{
+				return;
+			}
+
+			std::unique_lock lock { m_mutex };
+
+			if (lookup(hash, content) != std::end(m_table))
+			{
+				return;
+			}
+
+			// Evict the oldest entries first.
+			while (!m_order.empty() && m_size + bytes > m_capacity)
+			{
+				evict(m_order.front());
+				m_order.pop_front();
+			}
+
+			const auto it = m_table.emplace(hash, Entry { content, std::move(value), bytes });
+
+			m_order.emplace_back(hash, &it->second);
+			m_size += bytes;
+		}
+
+	private:
+		struct Entry
+		{
+			std::string content;
+			std::shared_ptr<const Value> value;
+			std::size_t bytes;
+		};
+
+		using Table = std::unordered_multimap<std::size_t, Entry>;
+
+		[[nodiscard]]
+		typename Table::const_iterator lookup(std::size_t hash, const std::string& content) const
+		{
+			const auto [first, last] = m_table.equal_range(hash);
+
+			for (auto it = first; it != last; ++it)
+			{
+				if (it->second.content == content)
+				{
+					return it;
+				}
+			}
+
+			return std::end(m_table);
+		}
+
+		// Erases the entry itself rather than another one with the same hash; elements of an
+		// unordered container keep their address across rehashes.
+		void evict(const std::pair<std::size_t, const Entry*>& oldest)
+		{
+			const auto [first, last] = m_table.equal_range(oldest.first);
+
+			for (auto it = first; it != last; ++it)
+			{
+				if (&it->second == oldest.second)
+				{
+					m_size -= it->second.bytes;
+					m_table.erase(it);
+
+					return;
+				}
+			}
+		}
+
+		std::size_t m_capacity;
+		std::size_t m_size;
+		mutable std::shared_mutex m_mutex;
+		Table m_table;
+		std::deque<std::pair<std::size_t, const Entry*>> m_order;
+	};
+}
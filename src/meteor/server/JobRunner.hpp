@@ -0,0 +1,153 @@
+/*================================================================================
+ * The MIT License
+ *
+ * Copyright (c) 2018 Ryooooooga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+================================================================================*/
+
+#pragma once
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+#include "ContentCache.hpp"
+#include "../cc/Compiler.hpp"
+#include "../cc/Parser.hpp"
+#include "../cc/SymbolAnalyzer.hpp"
+#include "../runtime/Processor.hpp"
+
+namespace meteor::server
+{
+	struct JobResult
+	{
+		enum class Status: std::uint32_t
+		{
+			exited = 0,
+			budgetExhausted = 1,
+			stopped = 2,
+			error = 3,
+		};
+
+		Status status;
+		Word exitStatus;
+		std::string output; // Output of the guest, or the error message.
+	};
+
+	// Compiles and runs (source, input) jobs.
+	// Compiled images and the results of runs are memoized by content; a run is deterministic
+	// because the guest only sees the input and the step budget is fixed.
+	class JobRunner
+	{
+	public:
+		// Each cache holds at most `cacheCapacity` bytes of keys and values.
+		explicit JobRunner(std::uint64_t budget, std::size_t cacheCapacity = 64 << 20)
+			: m_budget(budget)
+			, m_images(cacheCapacity)
+			, m_results(cacheCapacity)
+		{
+		}
+
+		// Uncopyable, unmovable.
+		JobRunner(const JobRunner&) =delete;
+		JobRunner(JobRunner&&) =delete;
+
+		JobRunner& operator=(const JobRunner&) =delete;
+		JobRunner& operator=(JobRunner&&) =delete;
+
+		~JobRunner() =default;
+
+		[[nodiscard]]
+		std::shared_ptr<const JobResult> run(const std::string& source, const std::string& input)
+		{
+			const auto key = std::to_string(source.size()) + u8":" + source + input;
+
+			if (auto result = m_results.find(key))
+			{
+				return result;
+			}
+
+			auto result = std::make_shared<const JobResult>(execute(source, input));
+
+			m_results.insert(key, result, sizeof(JobResult) + result->output.size());
+
+			return result;
+		}
+
+	private:
+		[[nodiscard]]
+		JobResult execute(const std::string& source, const std::string& input)
+		{
+			try
+			{
+				const auto image = compile(source);
+
+				std::istringstream inputStream { input };
+				std::ostringstream outputStream;
+
+				auto processor = runtime::Processor { std::make_shared<runtime::Memory>(*image) };
+
+				processor.input(inputStream);
+				processor.output(outputStream);
+
+				if (processor.run(m_budget))
+				{
+					return JobResult { JobResult::Status::budgetExhausted, 0, outputStream.str() };
+				}
+				else if (const auto status = processor.exitStatus())
+				{
+					return JobResult { JobResult::Status::exited, *status, outputStream.str() };
+				}
+				else
+				{
+					return JobResult { JobResult::Status::stopped, 0, outputStream.str() };
+				}
+			}
+			catch (const std::exception& e)
+			{
+				return JobResult { JobResult::Status::error, 0, e.what() };
+			}
+		}
+
+		[[nodiscard]]
+		std::shared_ptr<const std::vector<Word>> compile(const std::string& source)
+		{
+			if (auto image = m_images.find(source))
+			{
+				return image;
+			}
+
+			auto parser = cc::Parser { u8"<job>", source };
+			auto ast = parser.parse();
+
+			cc::SymbolAnalyzer {}.resolve(*ast);
+
+			auto image = std::make_shared<const std::vector<Word>>(cc::Compiler {}.compile(*ast));
+
+			m_images.insert(source, image, image->size() * sizeof(Word));
+
+			return image;
+		}
+
+		std::uint64_t m_budget;
+		ContentCache<std::vector<Word>> m_images;
+		ContentCache<JobResult> m_results;
+	};
+}
@@ -0,0 +1,526 @@
+/*================================================================================
+ * The MIT License
+ *
+ * Copyright (c) 2018 Ryooooooga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+================================================================================*/
+
+#pragma once
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <system_error>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "JobRunner.hpp"
+#include "ThreadPool.hpp"
+
+namespace meteor::server
+{
+	// Wire format (little endian):
+	//     request:  u32 source-length, source, u32 input-length, input
+	//     response: u32 status, u32 exit-status, u32 output-length, output
+	namespace protocol
+	{
+		// Longest source, input or output carried by one message.
+		constexpr std::uint32_t maximumLength = 16 << 20;
+
+		// Time the server allows for reading a whole request, and again for writing the response.
+		constexpr std::chrono::seconds timeout { 10 };
+
+		class Socket
+		{
+		public:
+			explicit Socket(int fd) noexcept
+				: m_fd(fd)
+				, m_deadline()
+			{
+			}
+
+			// Uncopyable, movable.
+			Socket(const Socket&) =delete;
+			Socket(Socket&& other) noexcept
+				: m_fd(std::exchange(other.m_fd, -1))
+				, m_deadline(other.m_deadline)
+			{
+			}
+
+			Socket& operator=(const Socket&) =delete;
+			Socket& operator=(Socket&& other) noexcept
+			{
+				std::swap(m_fd, other.m_fd);
+				std::swap(m_deadline, other.m_deadline);
+				return *this;
+			}
+
+			~Socket()
+			{
+				if (m_fd >= 0)
+				{
+					::close(m_fd);
+				}
+			}
+
+			[[nodiscard]]
+			int fd() const noexcept
+			{
+				return m_fd;
+			}
+
+			// Reads and writes throw once `deadline` has passed, however the peer trickles its bytes.
+			// Without a deadline they wait indefinitely.
+			void deadline(std::optional<std::chrono::steady_clock::time_point> deadline) noexcept
+			{
+				m_deadline = deadline;
+			}
+
+			// Returns false on end of stream before the first byte.
+			[[nodiscard]]
+			bool read(void* buffer, std::size_t size)
+			{
+				auto p = static_cast<char*>(buffer);
+
+				for (std::size_t done = 0; done < size; )
+				{
+					wait(POLLIN);
+
+					const auto n = ::recv(m_fd, p + done, size - done, MSG_DONTWAIT);
+
+					if (n == 0 && done == 0)
+					{
+						return false;
+					}
+					else if (n == 0)
+					{
+						throw std::runtime_error { u8"unexpected end of stream." };
+					}
+					else if (n < 0 && errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK)
+					{
+						throw std::system_error { errno, std::generic_category(), u8"read" };
+					}
+
+					done += n > 0 ? static_cast<std::size_t>(n) : 0;
+				}
+
+				return true;
+			}
+
+			void write(const void* buffer, std::size_t size)
+			{
+				auto p = static_cast<const char*>(buffer);
+
+				for (std::size_t done = 0; done < size; )
+				{
+					wait(POLLOUT);
+
+					const auto n = ::send(m_fd, p + done, size - done, MSG_NOSIGNAL | MSG_DONTWAIT);
+
+					if (n < 0 && errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK)
+					{
+						throw std::system_error { errno, std::generic_category(), u8"write" };
+					}
+
+					done += n > 0 ? static_cast<std::size_t>(n) : 0;
+				}
+			}
+
+			[[nodiscard]]
+			bool readInteger(std::uint32_t& value)
+			{
+				unsigned char bytes[4];
+
+				if (!read(bytes, sizeof(bytes)))
+				{
+					return false;
+				}
+
+				value = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (std::uint32_t {bytes[3]} << 24);
+
+				return true;
+			}
+
+			void writeInteger(std::uint32_t value)
+			{
+				const unsigned char bytes[4] =
+				{
+					static_cast<unsigned char>(value),
+					static_cast<unsigned char>(value >> 8),
+					static_cast<unsigned char>(value >> 16),
+					static_cast<unsigned char>(value >> 24),
+				};
+
+				write(bytes, sizeof(bytes));
+			}
+
+			// Returns false on end of stream before the first byte.
+			[[nodiscard]]
+			bool readString(std::string& s)
+			{
+				std::uint32_t size;
+
+				if (!readInteger(size))
+				{
+					return false;
+				}
+
+				if (size > maximumLength)
+				{
+					throw std::runtime_error { (boost::format(u8"message of %1% bytes exceeds the limit of %2% bytes.") % size % maximumLength).str() };
+				}
+
+				s.assign(size, u8'\0');
+
+				if (size > 0 && !read(s.data(), size))
+				{
+					throw std::runtime_error { u8"unexpected end of stream." };
+				}
+
+				return true;
+			}
+
+			[[nodiscard]]
+			std::string readString()
+			{
+				std::string s;
+
+				if (!readString(s))
+				{
+					throw std::runtime_error { u8"unexpected end of stream." };
+				}
+
+				return s;
+			}
+
+			void writeString(std::string_view s)
+			{
+				writeInteger(static_cast<std::uint32_t>(s.size()));
+				write(s.data(), s.size());
+			}
+
+		private:
+			// Waits until the socket is ready for `events`, or throws if the deadline passes first.
+			void wait(short events)
+			{
+				auto fd = pollfd { m_fd, events, 0 };
+
+				while (true)
+				{
+					int milliseconds = -1;
+
+					if (m_deadline)
+					{
+						const auto left = std::chrono::ceil<std::chrono::milliseconds>(*m_deadline - std::chrono::steady_clock::now()).count();
+
+						if (left <= 0)
+						{
+							throw std::runtime_error { u8"the peer timed out." };
+						}
+
+						milliseconds = static_cast<int>(std::min<decltype(left)>(left, std::numeric_limits<int>::max()));
+					}
+
+					const auto n = ::poll(&fd, 1, milliseconds);
+
+					if (n > 0)
+					{
+						return;
+					}
+					else if (n < 0 && errno != EINTR)
+					{
+						throw std::system_error { errno, std::generic_category(), u8"poll" };
+					}
+				}
+			}
+
+			int m_fd;
+			std::optional<std::chrono::steady_clock::time_point> m_deadline;
+		};
+
+		[[nodiscard]]
+		inline sockaddr_un address(const std::string& path)
+		{
+			sockaddr_un address {};
+
+			if (path.size() >= sizeof(address.sun_path))
+			{
+				throw std::runtime_error { u8"too long socket path `" + path + u8"'." };
+			}
+
+			address.sun_family = AF_UNIX;
+			std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+			return address;
+		}
+
+		[[nodiscard]]
+		inline Socket open()
+		{
+			Socket socket { ::socket(AF_UNIX, SOCK_STREAM, 0) };
+
+			if (socket.fd() < 0)
+			{
+				throw std::system_error { errno, std::generic_category(), u8"socket" };
+			}
+
+			return socket;
+		}
+	}
+
+	// Long-lived server answering jobs on a Unix socket.
+	// A connection may submit any number of jobs in sequence. Idle connections are watched by the
+	// accepting thread and only take a pool thread while one request is read and answered.
+	class JobServer
+	{
+	public:
+		explicit JobServer(std::string path, std::size_t threads, std::uint64_t budget)
+			: m_path(std::move(path))
+			, m_runner(budget)
+			, m_mutex()
+			, m_returned()
+			, m_wake(wakePair())
+			, m_pool(threads)
+		{
+			if (threads == 0)
+			{
+				throw std::invalid_argument { u8"the server needs at least one thread." };
+			}
+		}
+
+		// Uncopyable, unmovable.
+		JobServer(const JobServer&) =delete;
+		JobServer(JobServer&&) =delete;
+
+		JobServer& operator=(const JobServer&) =delete;
+		JobServer& operator=(JobServer&&) =delete;
+
+		~JobServer() =default;
+
+		[[noreturn]]
+		void serve()
+		{
+			auto listener = protocol::open();
+			const auto address = protocol::address(m_path);
+
+			::unlink(m_path.c_str());
+
+			if (::bind(listener.fd(), reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0)
+			{
+				throw std::system_error { errno, std::generic_category(), u8"bind" };
+			}
+
+			if (::listen(listener.fd(), SOMAXCONN) < 0)
+			{
+				throw std::system_error { errno, std::generic_category(), u8"listen" };
+			}
+
+			std::vector<std::shared_ptr<protocol::Socket>> idle;
+			std::vector<pollfd> fds;
+
+			while (true)
+			{
+				fds.clear();
+				fds.push_back(pollfd { listener.fd(), POLLIN, 0 });
+				fds.push_back(pollfd { m_wake.first.fd(), POLLIN, 0 });
+
+				for (const auto& connection : idle)
+				{
+					fds.push_back(pollfd { connection->fd(), POLLIN, 0 });
+				}
+
+				if (::poll(fds.data(), fds.size(), -1) < 0)
+				{
+					if (errno == EINTR)
+					{
+						continue;
+					}
+
+					throw std::system_error { errno, std::generic_category(), u8"poll" };
+				}
+
+				// A request or a hang-up: the pool answers it and hands the connection back.
+				for (auto i = idle.size(); i-- > 0; )
+				{
+					if (fds[i + 2].revents != 0)
+					{
+						m_pool.submit([this, connection = std::move(idle[i])] { answer(connection); });
+
+						idle.erase(std::begin(idle) + i);
+					}
+				}
+
+				if (fds[1].revents != 0)
+				{
+					char buffer[256];
+
+					while (::recv(m_wake.first.fd(), buffer, sizeof(buffer), MSG_DONTWAIT) > 0)
+					{
+					}
+
+					std::lock_guard lock { m_mutex };
+
+					std::move(std::begin(m_returned), std::end(m_returned), std::back_inserter(idle));
+					m_returned.clear();
+				}
+
+				if (fds[0].revents != 0)
+				{
+					const auto fd = ::accept(listener.fd(), nullptr, nullptr);
+
+					if (fd < 0)
+					{
+						if (errno == EINTR || errno == ECONNABORTED)
+						{
+							continue;
+						}
+
+						throw std::system_error { errno, std::generic_category(), u8"accept" };
+					}
+
+					idle.emplace_back(std::make_shared<protocol::Socket>(fd));
+				}
+			}
+		}
+
+	private:
+		[[nodiscard]]
+		static std::pair<protocol::Socket, protocol::Socket> wakePair()
+		{
+			int fds[2];
+
+			if (::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0)
+			{
+				throw std::system_error { errno, std::generic_category(), u8"socketpair" };
+			}
+
+			return { protocol::Socket { fds[0] }, protocol::Socket { fds[1] } };
+		}
+
+		// Answers one request, then returns the connection to serve(). Closed or faulty connections are dropped.
+		void answer(const std::shared_ptr<protocol::Socket>& connection)
+		{
+			try
+			{
+				std::string source;
+
+				connection->deadline(std::chrono::steady_clock::now() + protocol::timeout);
+
+				if (!connection->readString(source))
+				{
+					return;
+				}
+
+				const auto input = connection->readString();
+
+				connection->deadline(std::nullopt);
+
+				const auto result = m_runner.run(source, input);
+
+				connection->deadline(std::chrono::steady_clock::now() + protocol::timeout);
+
+				if (result->output.size() > protocol::maximumLength)
+				{
+					connection->writeInteger(static_cast<std::uint32_t>(JobResult::Status::error));
+					connection->writeInteger(0);
+					connection->writeString((boost::format(u8"output of %1% bytes exceeds the limit of %2% bytes.") % result->output.size() % protocol::maximumLength).str());
+				}
+				else
+				{
+					connection->writeInteger(static_cast<std::uint32_t>(result->status));
+					connection->writeInteger(result->exitStatus);
+					connection->writeString(result->output);
+				}
+
+				connection->deadline(std::nullopt);
+
+				{
+					std::lock_guard lock { m_mutex };
+					m_returned.emplace_back(connection);
+				}
+
+				const char wake = 0;
+
+				m_wake.second.write(&wake, sizeof(wake));
+			}
+			catch (const std::exception& e)
+			{
+				std::cerr << boost::format(u8"connection closed: %1%") % e.what() << std::endl;
+			}
+		}
+
+		std::string m_path;
+		JobRunner m_runner;
+		std::mutex m_mutex;
+		std::vector<std::shared_ptr<protocol::Socket>> m_returned;
+		std::pair<protocol::Socket, protocol::Socket> m_wake;
+		ThreadPool m_pool;
+	};
+
+	// Client side of JobServer.
+	class JobClient
+	{
+	public:
+		explicit JobClient(const std::string& path)
+			: m_socket(protocol::open())
+		{
+			const auto address = protocol::address(path);
+
+			if (::connect(m_socket.fd(), reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0)
+			{
+				throw std::system_error { errno, std::generic_category(), u8"connect" };
+			}
+		}
+
+		[[nodiscard]]
+		JobResult submit(std::string_view source, std::string_view input)
+		{
+			m_socket.writeString(source);
+			m_socket.writeString(input);
+
+			std::uint32_t status;
+			std::uint32_t exitStatus;
+
+			if (!m_socket.readInteger(status) || !m_socket.readInteger(exitStatus))
+			{
+				throw std::runtime_error { u8"connection closed by the server." };
+			}
+
+			if (status > static_cast<std::uint32_t>(JobResult::Status::error) || exitStatus > 0xffff)
+			{
+				throw std::runtime_error { u8"malformed response from the server." };
+			}
+
+			return JobResult { static_cast<JobResult::Status>(status), static_cast<Word>(exitStatus), m_socket.readString() };
+		}
+
+	private:
+		protocol::Socket m_socket;
+	};
+}
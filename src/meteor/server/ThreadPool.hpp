@@ -0,0 +1,117 @@
+/*================================================================================
+ * The MIT License
+ *
+ * Copyright (c) 2018 Ryooooooga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+================================================================================*/
+
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace meteor::server
+{
+	// Fixed-size pool of worker threads.
+	class ThreadPool
+	{
+	public:
+		explicit ThreadPool(std::size_t size)
+			: m_mutex()
+			, m_condition()
+			, m_tasks()
+			, m_stopping(false)
+			, m_threads()
+		{
+			for (std::size_t i = 0; i < size; i++)
+			{
+				m_threads.emplace_back([this] { work(); });
+			}
+		}
+
+		// Uncopyable, unmovable.
+		ThreadPool(const ThreadPool&) =delete;
+		ThreadPool(ThreadPool&&) =delete;
+
+		ThreadPool& operator=(const ThreadPool&) =delete;
+		ThreadPool& operator=(ThreadPool&&) =delete;
+
+		// Finishes the queued tasks and joins the workers.
+		~ThreadPool()
+		{
+			{
+				std::lock_guard lock { m_mutex };
+				m_stopping = true;
+			}
+
+			m_condition.notify_all();
+
+			for (auto& thread : m_threads)
+			{
+				thread.join();
+			}
+		}
+
+		void submit(std::function<void()> task)
+		{
+			{
+				std::lock_guard lock { m_mutex };
+				m_tasks.emplace(std::move(task));
+			}
+
+			m_condition.notify_one();
+		}
+
+	private:
+		void work()
+		{
+			while (true)
+			{
+				std::function<void()> task;
+
+				{
+					std::unique_lock lock { m_mutex };
+
+					m_condition.wait(lock, [this] { return m_stopping || !m_tasks.empty(); });
+
+					if (m_tasks.empty())
+					{
+						return;
+					}
+
+					task = std::move(m_tasks.front());
+					m_tasks.pop();
+				}
+
+				task();
+			}
+		}
+
+		std::mutex m_mutex;
+		std::condition_variable m_condition;
+		std::queue<std::function<void()>> m_tasks;
+		bool m_stopping;
+		std::vector<std::thread> m_threads;
+	};
+}
@@ -0,0 +1,276 @@
+/*================================================================================
+ * The MIT License
+ *
+ * Copyright (c) 2018 Ryooooooga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+================================================================================*/
+
+#include "meteor/cc/Compiler.hpp"
+#include "meteor/cc/Parser.hpp"
+#include "meteor/cc/SymbolAnalyzer.hpp"
+
+#include "meteor/runtime/Lockstep.hpp"
+#include "meteor/runtime/Processor.hpp"
+#include "meteor/runtime/RandomProgram.hpp"
+#include "meteor/runtime/UndoLog.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+
+#include <boost/format.hpp>
+
+namespace
+{
+	struct Options
+	{
+		std::string sourcePath;
+		std::string engine = u8"run";
+		meteor::runtime::Granularity granularity = meteor::runtime::Granularity::step;
+		std::uint64_t budget = 10000;
+		std::uint64_t programs = 1000;
+		std::size_t length = 64;
+		std::uint64_t seed = 1;
+	};
+
+	[[noreturn]]
+	void usage()
+	{
+		throw std::runtime_error {
+			u8"usage: meteor_lockstep [SOURCE] [--engine step|run|undo] [--granularity step|block|exit] "
+			u8"[--budget N] [--programs N] [--length N] [--seed N]"
+		};
+	}
+
+	[[nodiscard]]
+	Options parseOptions(int argc, char* argv[])
+	{
+		Options options;
+
+		for (int i = 1; i < argc; i++)
+		{
+			const std::string_view arg = argv[i];
+
+			if (arg == u8"--engine" && i + 1 < argc)
+			{
+				options.engine = argv[++i];
+			}
+			else if (arg == u8"--granularity" && i + 1 < argc)
+			{
+				const std::string_view value = argv[++i];
+
+				if (value == u8"step")
+				{
+					options.granularity = meteor::runtime::Granularity::step;
+				}
+				else if (value == u8"block")
+				{
+					options.granularity = meteor::runtime::Granularity::block;
+				}
+				else if (value == u8"exit")
+				{
+					options.granularity = meteor::runtime::Granularity::exit;
+				}
+				else
+				{
+					usage();
+				}
+			}
+			else if (arg == u8"--budget" && i + 1 < argc)
+			{
+				options.budget = std::stoull(argv[++i]);
+			}
+			else if (arg == u8"--programs" && i + 1 < argc)
+			{
+				options.programs = std::stoull(argv[++i]);
+			}
+			else if (arg == u8"--length" && i + 1 < argc)
+			{
+				options.length = std::stoul(argv[++i]);
+			}
+			else if (arg == u8"--seed" && i + 1 < argc)
+			{
+				options.seed = std::stoull(argv[++i]);
+			}
+			else if (!arg.empty() && arg[0] != u8'-' && options.sourcePath.empty())
+			{
+				options.sourcePath = arg;
+			}
+			else
+			{
+				usage();
+			}
+		}
+
+		if (options.engine != u8"step" && options.engine != u8"run" && options.engine != u8"undo")
+		{
+			usage();
+		}
+
+		return options;
+	}
+
+	[[nodiscard]]
+	std::vector<meteor::Word> compile(const std::string& path)
+	{
+		std::ifstream stream { path };
+
+		if (!stream)
+		{
+			throw std::runtime_error { (boost::format(u8"cannot open `%1%'.") % path).str() };
+		}
+
+		const auto source = std::string { std::istreambuf_iterator<char> { stream }, std::istreambuf_iterator<char> {} };
+		auto ast = meteor::cc::Parser { path, source }.parse();
+
+		meteor::cc::SymbolAnalyzer {}.resolve(*ast);
+
+		return meteor::cc::Compiler {}.compile(*ast);
+	}
+
+	template <typename Candidate, typename Advance>
+	[[nodiscard]]
+	std::optional<meteor::runtime::Divergence> lockstep(const std::vector<meteor::Word>& image, const Options& options, Candidate& candidate, Advance advance)
+	{
+		auto harness = meteor::runtime::Lockstep { options.granularity };
+		auto reference = meteor::runtime::BasicProcessor { std::make_shared<meteor::runtime::Memory>(image), harness };
+		std::istringstream referenceInput;
+		std::istringstream candidateInput;
+		std::ostringstream referenceOutput;
+		std::ostringstream candidateOutput;
+
+		reference.input(referenceInput);
+		candidate.input(candidateInput);
+		reference.output(referenceOutput);
+		candidate.output(candidateOutput);
+
+		auto divergence = harness.run(reference, candidate, advance, options.budget);
+
+		if (!divergence && referenceOutput.str() != candidateOutput.str())
+		{
+			divergence = meteor::runtime::Divergence { reference.steps(), u8"the outputs differ", {} };
+		}
+
+		return divergence;
+	}
+
+	// Runs the chosen candidate engine against the reference on one image.
+	[[nodiscard]]
+	std::optional<meteor::runtime::Divergence> check(const std::vector<meteor::Word>& image, const Options& options, std::uint64_t seed)
+	{
+		const auto memory = std::make_shared<meteor::runtime::Memory>(image);
+
+		if (options.engine == u8"undo")
+		{
+			// Executes every instruction, rolls it back and executes it again.
+			// System calls are executed once, since I/O cannot be rolled back.
+			auto undoLog = meteor::runtime::UndoLog {};
+			auto candidate = meteor::runtime::BasicProcessor { memory, undoLog };
+
+			return lockstep(image, options, candidate, [](auto& processor)
+			{
+				const auto pc = processor.getRegister(meteor::Register::programCounter);
+
+				if (meteor::operations::operationCode(processor.memory()->read(pc)) == meteor::operations::svc)
+				{
+					return processor.step();
+				}
+
+				const auto running = processor.step();
+
+				return processor.stepBack(1) == 1 ? processor.step() : running;
+			});
+		}
+
+		auto candidate = meteor::runtime::Processor { memory };
+
+		if (options.engine == u8"run")
+		{
+			// Runs random slices through the budgeted loop.
+			std::mt19937_64 random { seed };
+
+			return lockstep(image, options, candidate, [&](auto& processor)
+			{
+				return processor.run(std::uniform_int_distribution<std::uint64_t> { 1, 64 }(random));
+			});
+		}
+
+		return lockstep(image, options, candidate, [](auto& processor)
+		{
+			return processor.step();
+		});
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	try
+	{
+		const auto options = parseOptions(argc, argv);
+
+		if (!options.sourcePath.empty())
+		{
+			if (const auto divergence = check(compile(options.sourcePath), options, options.seed))
+			{
+				divergence->print(std::cout);
+
+				return 1;
+			}
+
+			std::cout << u8"no divergence." << std::endl;
+
+			return 0;
+		}
+
+		auto generator = meteor::runtime::RandomProgram { options.seed };
+
+		// Random programs often hit invalid instructions, which both engines report on std::cerr.
+		const auto errors = std::cerr.rdbuf(nullptr);
+
+		for (std::uint64_t i = 0; i < options.programs; i++)
+		{
+			const auto image = generator.generate(options.length);
+
+			if (const auto divergence = check(image, options, options.seed + i))
+			{
+				std::cerr.rdbuf(errors);
+				std::cerr.clear();
+
+				std::cout << boost::format(u8"program %1% of seed %2%:") % i % options.seed << std::endl;
+
+				divergence->print(std::cout);
+
+				return 1;
+			}
+		}
+
+		std::cerr.rdbuf(errors);
+		std::cerr.clear();
+
+		std::cout << boost::format(u8"%1% programs, no divergence.") % options.programs << std::endl;
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+
+		return 1;
+	}
+}
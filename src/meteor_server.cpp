@@ -0,0 +1,127 @@
+/*================================================================================
+ * The MIT License
+ *
+ * Copyright (c) 2018 Ryooooooga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+================================================================================*/
+
+#include "meteor/server/JobServer.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+	std::string readFile(const std::string& path)
+	{
+		std::ifstream stream { path, std::ios::binary };
+
+		if (!stream)
+		{
+			throw std::runtime_error { u8"cannot open `" + path + u8"'." };
+		}
+
+		return std::string { std::istreambuf_iterator<char> { stream }, std::istreambuf_iterator<char> {} };
+	}
+
+	[[noreturn]]
+	void usage()
+	{
+		throw std::runtime_error {
+			u8"usage: meteor_server SOCKET [--threads N] [--budget STEPS]\n"
+			u8"       meteor_server --submit SOCKET SOURCE [INPUT]" };
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	try
+	{
+		if (argc >= 4 && std::string_view { argv[1] } == u8"--submit")
+		{
+			const auto source = readFile(argv[3]);
+			const auto input = argc >= 5 ? readFile(argv[4]) : std::string {};
+
+			auto client = meteor::server::JobClient { argv[2] };
+
+			const auto start = std::chrono::steady_clock::now();
+			const auto result = client.submit(source, input);
+			const auto elapsed = std::chrono::steady_clock::now() - start;
+
+			if (result.status == meteor::server::JobResult::Status::error)
+			{
+				std::cerr << result.output << std::endl;
+			}
+			else
+			{
+				std::cout << result.output;
+			}
+
+			std::cerr
+				<< boost::format(u8"status %1%, exit status %2%, %3% us")
+					% static_cast<std::uint32_t>(result.status)
+					% result.exitStatus
+					% std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()
+				<< std::endl;
+
+			return result.status == meteor::server::JobResult::Status::exited ? result.exitStatus : 1;
+		}
+
+		if (argc < 2)
+		{
+			usage();
+		}
+
+		std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+		std::uint64_t budget = 10'000'000;
+
+		for (int i = 2; i < argc; i++)
+		{
+			const std::string_view arg = argv[i];
+
+			if (arg == u8"--threads" && i + 1 < argc)
+			{
+				threads = std::stoul(argv[++i]);
+
+				if (threads == 0)
+				{
+					throw std::runtime_error { u8"--threads must be at least 1." };
+				}
+			}
+			else if (arg == u8"--budget" && i + 1 < argc)
+			{
+				budget = std::stoull(argv[++i]);
+			}
+			else
+			{
+				usage();
+			}
+		}
+
+		meteor::server::JobServer { argv[1], threads, budget }.serve();
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+
+		return 1;
+	}
+}
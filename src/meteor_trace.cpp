@@ -0,0 +1,157 @@
+/*================================================================================
+ * The MIT License
+ *
+ * Copyright (c) 2018 Ryooooooga
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+================================================================================*/
+#include "meteor/runtime/ExecutionTrace.hpp"
+#include "meteor/Disassembler.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <limits>
+
+#include <boost/format.hpp>
+
+namespace
+{
+	[[noreturn]]
+	void usage()
+	{
+		throw std::runtime_error { u8"usage: meteor_trace TRACE [--from INDEX] [--count N] [--summary]" };
+	}
+
+	void print(const meteor::runtime::ExecutionTraceReader::Record& record)
+	{
+		const auto mnemonic = meteor::operations::mnemonic(record.instruction);
+
+		std::cout << boost::format(u8"%1$12d %2$04X %3$04X %4$-5s") % record.index % record.pc % record.instruction % (mnemonic ? mnemonic : u8"?");
+
+		for (std::size_t i = 0; i < meteor::runtime::execution_trace::trackedRegisters; i++)
+		{
+			if (record.changed & (1 << i))
+			{
+				const auto reg = meteor::runtime::execution_trace::trackedRegister(i);
+
+				std::cout << boost::format(u8" %1%=%2$04X") % meteor::toString(reg) % record.registers[i];
+			}
+		}
+
+		for (const auto& [address, value] : record.writes)
+		{
+			std::cout << boost::format(u8" [%1$04X]=%2$04X") % address % value;
+		}
+
+		std::cout << std::endl;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	try
+	{
+		if (argc < 2)
+		{
+			usage();
+		}
+
+		std::uint64_t from = 0;
+		std::uint64_t count = std::numeric_limits<std::uint64_t>::max();
+		bool summary = false;
+
+		for (int i = 2; i < argc; i++)
+		{
+			const std::string_view arg = argv[i];
+
+			if (arg == u8"--from" && i + 1 < argc)
+			{
+				from = std::stoull(argv[++i]);
+			}
+			else if (arg == u8"--count" && i + 1 < argc)
+			{
+				count = std::stoull(argv[++i]);
+			}
+			else if (arg == u8"--summary")
+			{
+				summary = true;
+			}
+			else
+			{
+				usage();
+			}
+		}
+
+		std::ifstream stream { argv[1], std::ios::binary };
+
+		if (!stream)
+		{
+			throw std::runtime_error { std::string { u8"cannot open `" } + argv[1] + u8"'." };
+		}
+
+		auto reader = meteor::runtime::ExecutionTraceReader { stream };
+		auto record = meteor::runtime::ExecutionTraceReader::Record {};
+
+		// Decoding starts at the closest keyframe; the records before `from' are still skipped below.
+		if (!summary && from > 0)
+		{
+			reader.seek(from);
+		}
+
+		std::uint64_t records = 0;
+		std::uint64_t writes = 0;
+
+		while (reader.next(record))
+		{
+			records++;
+			writes += record.writes.size();
+
+			if (!summary && record.index >= from)
+			{
+				if (count-- == 0)
+				{
+					break;
+				}
+
+				print(record);
+			}
+		}
+
+		if (summary)
+		{
+			const auto bytes = static_cast<std::uint64_t>(stream.tellg());
+
+			std::cout
+				<< boost::format(u8"records: %1%\nkeyframes: %2% (every %3%)\nmemory writes: %4%\nbytes: %5% (%6$.2f per record)")
+					% records
+					% reader.keyframes()
+					% reader.keyframeInterval()
+					% writes
+					% bytes
+					% (static_cast<double>(bytes) / std::max(records, std::uint64_t {1}))
+				<< std::endl;
+		}
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+
+		return 1;
+	}
+}